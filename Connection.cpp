@@ -1,4 +1,5 @@
 #include <netinet/tcp.h>
+#include <sys/un.h>
 #include <string.h>
 #include <assert.h>
 
@@ -6,68 +7,538 @@
 #include <event2/dns.h>
 #include <event2/bufferevent.h>
 #include <event2/buffer.h>
+#include <event2/bufferevent_ssl.h>
+#include <openssl/err.h>
 #include <evutil.h>
 
 #include "Connection.h"
+#include "TLS.h"
 #include "util.h"
 #include "config.h"
 
-Connection::Connection(struct event_base* _base, struct evdns_base* _evdns, 
-                      string _hostname, int _port, options_t _options) :
-  base(_base), evdns(_evdns), hostname(_hostname), port(_port), options(_options)
+template <class P>
+static void bev_event_cb(struct bufferevent *bev, short events, void *ptr) {
+  ConnectionT<P>* conn = (ConnectionT<P>*) ptr;
+  conn->event_callback(events);
+}
+
+template <class P>
+static void bev_read_cb(struct bufferevent *bev, void *ptr) {
+  ConnectionT<P>* conn = (ConnectionT<P>*) ptr;
+  conn->read_callback();
+}
+
+template <class P>
+static void bev_write_cb(struct bufferevent *bev, void *ptr) {
+  ConnectionT<P>* conn = (ConnectionT<P>*) ptr;
+  conn->write_callback();
+}
+
+template <class P>
+static void hedge_timer_cb(evutil_socket_t fd, short what, void *ptr) {
+  ConnectionT<P>* conn = (ConnectionT<P>*) ptr;
+  conn->hedge_callback();
+}
+
+template <class P>
+static void backend_cb(evutil_socket_t fd, short what, void *ptr) {
+  typename ConnectionT<P>::fetch_t *fetch =
+    (typename ConnectionT<P>::fetch_t *) ptr;
+  fetch->conn->fetch_callback(fetch);
+}
+
+template <class P>
+static void reconnect_cb(evutil_socket_t fd, short what, void *ptr) {
+  ConnectionT<P>* conn = (ConnectionT<P>*) ptr;
+  conn->reconnect_callback();
+}
+
+template <class P>
+ConnectionT<P>::ConnectionT(struct event_base* _base,
+                            struct evdns_base* _evdns, string _hostname,
+                            int _port, const options_t& _options,
+                            ConnectionStats& _stats, uint64_t _stream) :
+  Connection(_options, _stats), hostname(_hostname), port(_port),
+  base(_base), evdns(_evdns), stream(_stream), rng(_options.seed, _stream)
 {
   read_state  = INIT_READ;
   write_state = INIT_WRITE;
 
-  bev = bufferevent_socket_new(base, -1, BEV_OPT_CLOSE_ON_FREE);
-  bufferevent_setcb(bev, bev_read_cb, bev_write_cb, bev_event_cb, this);
+  router = NULL;
+  crossing = false;
+  peers.push_back(this);
+  server = 0;
+  outstanding = 0;
+  next_replica = 0;
+
+  draining = reconnecting = false;
+  churned_at = 0.0;
+  connect_start = 0.0;
+
+  hedge_timer = NULL;
+  hedges = NULL;
+  hedge_first = hedge_next = 1;
+  hedge_samples = 0;
+  hedge_threshold = -1.0;
+  if (options.hedge) {
+    DIE_Z(hedge_timer = evtimer_new(base, hedge_timer_cb<P>, this));
+    hedges = new deque<hedge_t>();
+    if (options.hedge_percentile == 0.0)
+      hedge_threshold = options.hedge_after / 1000000;
+  }
+
+  // Percentile thresholds are unknown until enough requests are answered.
+  tracer = NULL;
+  if (options.trace) {
+    tracer = new tracer_t();
+    for (int i = 0; i < Operation::COMMANDS; i++)
+      tracer->threshold[i] = options.trace_percentile > 0.0 ? INFINITY :
+        options.trace_after;
+  }
+
+  bev = NULL;
+  prot = NULL;
+
+  noreply_ops = options.noreply ? new deque<Operation>() : NULL;
+  unfenced = issued_unfenced = 0;
+
+  backend = NULL;
+  if (options.cache_aside) {
+    backend = createGenerator(options.backend);
+    backend->set_random(&rng);
+  }
+
+  expiry = NULL;
+  if (options.ttl) {
+    expiry = createGenerator(options.ttl_dist);
+    expiry->set_random(&rng);
+  }
+
+  popularity = NULL;
+  if (options.zipf > 0.0) {
+    popularity = new Zipf(options.keyspace, options.zipf);
+    popularity->set_random(&rng);
+  }
+
+  udp = NULL;
+  if (options.udp) udp = new UDPTransport(this, base, hostname, port);
+}
+
+template <class P>
+ConnectionT<P>::~ConnectionT() {
+  if (hedge_timer) event_free(hedge_timer);
+  delete hedges;
+  delete noreply_ops;
+  delete prot;
+  delete udp;
+  delete backend;
+  delete popularity;
+  delete expiry;
+  delete tracer;
+  for (auto fetch: fetches) {
+    event_free(fetch->timer);
+    delete fetch;
+  }
+  if (bev) bufferevent_free(bev);
+}
+
+/**
+ * Open a new socket to the server, closing the old one if there is one.
+ * Authentication is queued before anything else can be written to it.
+ */
+template <class P>
+void ConnectionT<P>::connect() {
+  if (bev) {
+    delete prot;
+    bufferevent_free(bev);
+  }
+
+  if (options.tls) {
+    SSL *ssl = tls_new(hostname + ":" + to_string(port));
+    bev = bufferevent_openssl_socket_new(base, -1, ssl,
+                                         BUFFEREVENT_SSL_CONNECTING,
+                                         BEV_OPT_CLOSE_ON_FREE);
+    bufferevent_openssl_set_allow_dirty_shutdown(bev, 1);
+  } else {
+    bev = bufferevent_socket_new(base, -1, BEV_OPT_CLOSE_ON_FREE);
+  }
+  bufferevent_setcb(bev, bev_read_cb<P>, bev_write_cb<P>, bev_event_cb<P>,
+                    this);
   bufferevent_enable(bev, EV_READ | EV_WRITE);
 
-  prot = new ProtocolMemcachedText(this, bev);
+  prot = new P(this, bev);
 
-  DIE_NZ(bufferevent_socket_connect_hostname(bev, evdns, AF_INET, hostname.c_str(), port));
+  connect_start = get_time();
+  read_state = prot->setup_connection_w() ? INIT_READ : CONN_SETUP;
+
+  if (is_unix()) {
+    struct sockaddr_un sun;
+    memset(&sun, 0, sizeof(sun));
+    sun.sun_family = AF_UNIX;
+    strncpy(sun.sun_path, hostname.c_str() + 5, sizeof(sun.sun_path) - 1);
+    DIE_NZ(bufferevent_socket_connect(bev, (struct sockaddr *) &sun, sizeof(sun)));
+  } else {
+    DIE_NZ(bufferevent_socket_connect_hostname(bev, evdns, AF_INET, hostname.c_str(), port));
+  }
+}
+
+// Close and reopen the connection once it has drained.
+template <class P>
+void ConnectionT<P>::churn() {
+  if (draining || reconnecting || !is_connected() || check_exit_condition())
+    return;
+
+  draining = true;
+  for (auto peer: peers) peer->fence_noreply();
+  maybe_reconnect();
+}
+
+// The socket is freed from a fresh callback rather than from within the
+// read callback that answered the last request.
+template <class P>
+void ConnectionT<P>::maybe_reconnect() {
+  if (!draining || outstanding > 0 || op_queue.size() > 0 ||
+      (noreply_ops && noreply_ops->size() > 0))
+    return;
+
+  draining = false;
+  reconnecting = true;
+  DIE_NZ(event_base_once(base, -1, EV_TIMEOUT, reconnect_cb<P>, this, NULL));
+}
+
+template <class P>
+void ConnectionT<P>::reconnect_callback() {
+  // A peer may have sent through this connection in the meantime.
+  if (op_queue.size() > 0 || (noreply_ops && noreply_ops->size() > 0)) {
+    reconnecting = false;
+    draining = true;
+    return;
+  }
+
+  stats.reconnects++;
+  churned_at = get_time();
+  connect();
+}
+
+// The connection is connected and authenticated.
+template <class P>
+void ConnectionT<P>::connection_ready() {
+  update_read_state();
+
+  if (reconnecting) {
+    stats.log_connect((get_time() - connect_start) * 1000000);
+    reconnecting = false;
+    for (auto peer: peers) peer->drive_write_machine();
+  }
+}
+
+template <class P>
+void ConnectionT<P>::set_routing(KeyRouter* _router,
+                                 const vector<Connection*>& _peers,
+                                 int _server) {
+  router = _router;
+  peers.clear();
+  for (auto peer: _peers) peers.push_back(static_cast<ConnectionT*>(peer));
+  server = _server;
+  crossing = peers.size() > 1 &&
+    (router || options.balance || options.fanout > 1);
 }
 
-Connection::~Connection() {
-  bufferevent_free(bev);
+template <class P>
+void ConnectionT<P>::set_backups(const vector<Connection*>& _backups) {
+  backups.clear();
+  for (auto b: _backups) backups.push_back(static_cast<ConnectionT*>(b));
 }
 
-void Connection::reset() {
+template <class P>
+void ConnectionT<P>::reset() {
   assert(op_queue.size() == 0);
   read_state = IDLE;
   write_state = INIT_WRITE;
-  stats = ConnectionStats();
 }
 
-void Connection::start_loading() {
+/**
+ * Load the records in [from, to) that this connection's server owns with
+ * noreply sets.  Every LOADER_CHUNK sets are followed by a fence, and up to
+ * LOADER_DEPTH fences are kept in flight.
+ */
+template <class P>
+void ConnectionT<P>::start_loading(int from, int to) {
+  loader_issued = from;
+  loader_end = to;
+
   read_state = LOADING;
-  loader_issued = loader_completed = 0;
+  while (op_queue.size() < LOADER_DEPTH && loader_issued < loader_end)
+    issue_load_chunk();
+  if (op_queue.size() == 0) read_state = IDLE;
+}
+
+template <class P>
+void ConnectionT<P>::issue_load_chunk() {
+  int sent = 0;
 
-  for (int i = 0; i < LOADER_CHUNK; i++) {
-    if (loader_issued >= options.records) break;
+  while (sent < LOADER_CHUNK && loader_issued < loader_end) {
     char key[256];
-    int index = lrand48() % (1024 * 1024);
     snprintf(key, 256, "%0*" PRIu64, options.keysize, (unsigned long)loader_issued);
-    issue_set(key, &random_char[index], options.valuesize);
     loader_issued++;
+
+    // Counters live under their own keys, which may belong to another
+    // server than their record's, and start at 0.
+    if (options.counters) {
+      char counter[257];
+      strcpy(counter, key);
+      counter_key(counter);
+      if (route(counter) == server) {
+        prot->set_request(counter, "0", 1, 0, true, string());
+        stats.loaded++;
+        stats.loaded_bytes++;
+        sent++;
+      }
+    }
+
+    if (route(key) != server) continue;
+
+    int index = rng.below(1024 * 1024);
+    // Part of the records can be made to expire all at once.
+    int exptime = ttl();
+    if (options.storm_at > 0.0 && rng.uniform() < options.storm_fraction)
+      exptime = (int) options.storm_at;
+
+    int length = value_size(key);
+    prot->set_request(key, &random_char[index], length, exptime, true,
+                      value_header(key, 0, &random_char[index], length));
+    stats.loaded++;
+    stats.loaded_bytes += length;
+    sent++;
   }
+
+  if (sent) issue_fence();
 }
 
-void Connection::issue_set_or_get(double now) {
+// Pick the replica for the next get according to --balance.
+template <class P>
+int ConnectionT<P>::pick_replica() {
+  int n = peers.size();
+  int best;
+
+  if (n == 1) return 0;
+
+  switch (options.balance) {
+  case BALANCE_RANDOM: return rng.below(n);
+  case BALANCE_ROUNDROBIN: return next_replica++ % n;
+
+  case BALANCE_LEAST:
+    // Rotate the starting point so that ties do not favour one server.
+    best = next_replica++ % n;
+    for (int i = 1; i < n; i++) {
+      int s = (best + i) % n;
+      if (peers[s]->queue_depth() < peers[best]->queue_depth()) best = s;
+    }
+    return best;
+
+  case BALANCE_P2C: {
+    int a = rng.below(n);
+    int b = rng.below(n - 1);
+    if (b >= a) b++;
+    return peers[b]->queue_depth() < peers[a]->queue_depth() ? b : a;
+  }
+
+  default: return server;
+  }
+}
+
+template <class P>
+void ConnectionT<P>::random_key(char* key) {
+  // Writes follow the same hot set as reads.
+  if (popularity) {
+    random_get_key(key);
+    return;
+  }
+
+  snprintf(key, 256, "%0*" PRIu64, options.keysize,
+           rng.below(options.records));
+}
+
+// Expiration time in seconds for a set, 0 for never.
+template <class P>
+int ConnectionT<P>::ttl() {
+  if (!expiry) return 0;
+
+  // Longer times would be taken for absolute unix times.
+  return (int) min(ceil(expiry->generate()), (double) MAXIMUM_TTL);
+}
+
+// With --slab-classes every key keeps its value in one class.
+template <class P>
+int ConnectionT<P>::slab_class(const char* key) {
+  if (!options.slab_classes) return -1;
+  return (uint32_t) hash_key(key) % options.slab_classes;
+}
+
+template <class P>
+int ConnectionT<P>::value_size(const char* key) {
+  int c = slab_class(key);
+  return c < 0 ? options.valuesize : options.slab_value[c];
+}
+
+// The --verify header that replaces the start of a value.
+template <class P>
+string ConnectionT<P>::value_header(const char* key, uint64_t version,
+                                    const char* value, int length) {
+  if (!options.verify) return string();
+
+  // The payload after the header; large ones wrap around the end of
+  // random_char, see Protocol::write_value().
+  uint32_t crc = 0;
+  size_t offset = value - random_char;
+  for (int len = length - sizeof(verify_header_t); len > 0; offset = 0) {
+    int n = min((size_t) len, RANDOM_CHAR_SIZE - offset);
+    crc = crc32c(crc, random_char + offset, n);
+    len -= n;
+  }
+
+  return verify_header(key, version, crc);
+}
+
+// Hand a completed request to the writer thread, see --record.
+template <class P>
+void ConnectionT<P>::record_op(const Operation& op) {
+  const char *key = op.key.c_str();
+  record_t r;
+
+  r.start_ns = op.start_time * 1e9;
+  r.latency_ns = (op.end_time - op.start_time) * 1e9;
+  r.key = key_index(key);
+  r.size = value_size(key);
+  r.connection = stream;
+  r.queue = min(op.queue, 65535);
+  r.type = op.type;
+  r.hits = min(op.hits, 255);
+
+  if (record->push(r)) stats.recorded++;
+  else stats.record_dropped++;
+}
+
+// Keep the context of a request answered on this connection if it was
+// slow, see --trace-slow.
+template <class P>
+void ConnectionT<P>::trace_op(const Operation& op) {
+  if (op.type >= Operation::COMMANDS) return;
+
+  tracer_t &tr = *tracer;
+
+  if (options.trace_percentile > 0.0 && ++tr.samples % HEDGE_UPDATE == 0) {
+    tr.threshold[Operation::GET] =
+      stats.get_sampler.get_nth(options.trace_percentile);
+    tr.threshold[Operation::SET] =
+      stats.set_sampler.get_nth(options.trace_percentile);
+    for (int i = Operation::SET + 1; i < Operation::COMMANDS; i++)
+      if (stats.cmd_ops[i])
+        tr.threshold[i] =
+          stats.cmd_samplers[i].get_nth(options.trace_percentile);
+  }
+
+  if (op.time() > tr.threshold[op.type]) {
+    trace_t t;
+    t.start_time = op.start_time;
+    t.end_time = op.end_time;
+    t.type = op.type;
+    t.key = op.key;
+    t.keys = op.keys;
+    t.hits = op.hits;
+    t.size = value_size(op.key.c_str());
+    t.connection = stream;
+    t.queue = op.queue;
+    t.behind = op_queue.size();
+
+    for (uint64_t i = tr.next; i > 0 && i + TRACE_AHEAD > tr.next; i--) {
+      answered_t &a = tr.answered[(i - 1) % TRACE_AHEAD];
+      if (a.end_time <= op.start_time) break;
+      t.ahead.push_back(a);
+    }
+
+    stats.log_slow(t);
+  }
+
+  answered_t &a = tr.answered[tr.next++ % TRACE_AHEAD];
+  a.type = op.type;
+  a.key = key_index(op.key.c_str());
+  a.start_time = op.start_time;
+  a.end_time = op.end_time;
+}
+
+// Counter keys are their record's key behind a 'c'.
+template <class P>
+uint64_t ConnectionT<P>::key_index(const char* key) {
+  return strtoull(key + (key[0] == 'c'), NULL, 10);
+}
+
+// The counter that belongs to a record key.
+template <class P>
+void ConnectionT<P>::counter_key(char* key) {
+  memmove(key + 1, key, strlen(key) + 1);
+  key[0] = 'c';
+}
+
+// Gets may ask for keys that were never loaded, see --keyspace.
+template <class P>
+void ConnectionT<P>::random_get_key(char* key) {
+  uint64_t k;
+
+  if (popularity) {
+    // Every connection computes the same hot set from the time since start.
+    uint64_t offset = 0;
+    double t = get_time() - start_time;
+    if (options.hot_drift > 0.0) offset += t * options.hot_drift;
+    if (options.hot_jump > 0.0)
+      offset += (uint64_t) (t / options.hot_jump) * 2654435761ULL;
+
+    k = ((uint64_t) popularity->generate() + offset) % options.keyspace;
+  } else if (options.hit_ratio < 0.0)
+    k = rng.below(options.keyspace);
+  else if (rng.uniform() < options.hit_ratio || options.keyspace == options.records)
+    k = rng.below(options.records);
+  else
+    k = options.records + rng.below(options.keyspace - options.records);
+
+  snprintf(key, 256, "%0*" PRIu64, options.keysize, k);
+}
+
+template <class P>
+void ConnectionT<P>::issue_set_or_get(double now) {
   char key[256];
-  snprintf(key, 256, "%0*" PRIu64, options.keysize, lrand48() % options.records);
+  int type = Operation::GET;
 
-  if (drand48() < options.ratio) {
-    int index = lrand48() % (1024 * 1024);
-    issue_set(key, &random_char[index], options.valuesize, now);
+  if (options.mix) {
+    double r = rng.uniform();
+    type = 0;
+    while (type < Operation::COMMANDS - 1 && r >= options.mix_cdf[type])
+      type++;
+  } else if (rng.uniform() < options.ratio) {
+    type = Operation::SET;
+  }
+
+  if (type == Operation::SET) {
+    int index = rng.below(1024 * 1024);
+    random_key(key);
+    issue_set(key, &random_char[index], value_size(key), now);
+  } else if (type != Operation::GET) {
+    random_key(key);
+    if (type == Operation::INCR || type == Operation::DECR) counter_key(key);
+    issue_command((Operation::type_enum) type, key, now);
+  } else if (options.fanout > 1) {
+    issue_fanout(options.fanout, now);
+  } else if (options.multiget > 1) {
+    issue_multiget(options.multiget, now);
   } else {
+    random_get_key(key);
     issue_get(key, now);
   }
 }
 
-void Connection::issue_get(const char* key, double now) {
+template <class P>
+void ConnectionT<P>::issue_get(const char* key, double now) {
   Operation op;
-  int l;
 
   if (now == 0.0) {
     op.start_time = get_time();
@@ -77,69 +548,568 @@ void Connection::issue_get(const char* key, double now) {
 
   op.key = string(key);
   op.type = Operation::GET;
+  op.size_class = slab_class(key);
+  op.origin = this;
+  if (options.verify) op.version = verify_latest(verify_slot(), key);
+
+  int s = options.balance ? pick_replica() : route(key);
+
+  if (hedge_timer) {
+    op.hedge_id = hedge_first + hedges->size();
+    hedges->push_back({op.start_time, op.key, s, 1, false, false});
+    if (!evtimer_pending(hedge_timer, NULL)) schedule_hedge();
+  }
+
+  outstanding++;
+  peers[s]->send_get(op);
+}
+
+/**
+ * Fetch count random keys.  The keys are grouped by the server that owns
+ * them, each group goes out as one get, and the request completes when the
+ * last group has been answered.
+ */
+template <class P>
+void ConnectionT<P>::issue_multiget(int count, double now) {
+  vector<string> groups(peers.size());
+  vector<int> sizes(peers.size(), 0);
+  int replica = options.balance ? pick_replica() : -1;
+
+  for (int i = 0; i < count; i++) {
+    char key[256];
+    random_get_key(key);
+
+    int s = replica >= 0 ? replica : route(key);
+    if (sizes[s]++ > 0) groups[s] += ' ';
+    groups[s] += key;
+  }
+
+  issue_split_get(groups, sizes, now);
+}
+
+/**
+ * Send a get for --multiget keys to each of count distinct servers picked
+ * at random.  With a router, the keys sent to a server are ones it owns.
+ */
+template <class P>
+void ConnectionT<P>::issue_fanout(int count, double now) {
+  vector<string> groups(peers.size());
+  vector<int> sizes(peers.size(), 0);
+  vector<int> order(peers.size());
+
+  for (size_t s = 0; s < order.size(); s++) order[s] = s;
+
+  for (int i = 0; i < count; i++) {
+    int j = i + rng.below(order.size() - i);
+    swap(order[i], order[j]);
+    int s = order[i];
+
+    for (int k = 0; k < options.multiget; k++) {
+      char key[256];
+      int tries = 0;
+      do {
+        random_get_key(key);
+      } while (router && router->route(key) != s &&
+               ++tries < FANOUT_KEY_TRIES);
+
+      if (sizes[s]++ > 0) groups[s] += ' ';
+      groups[s] += key;
+    }
+  }
+
+  issue_split_get(groups, sizes, now);
+}
+
+// Issue one logical get made of a get per non-empty group of keys.
+template <class P>
+void ConnectionT<P>::issue_split_get(vector<string>& groups,
+                                     vector<int>& sizes, double now) {
+  int shards = 0, count = 0;
+
+  if (now == 0.0) now = get_time();
+
+  for (size_t s = 0; s < sizes.size(); s++) {
+    if (sizes[s]) shards++;
+    count += sizes[s];
+  }
+
+  Operation *parent = NULL;
+  if (shards > 1) {
+    parent = new Operation();
+    parent->start_time = now;
+    parent->type = Operation::GET;
+    parent->keys = count;
+    parent->origin = this;
+    parent->pending = shards;
+  }
+
+  outstanding++;
+
+  for (size_t s = 0; s < peers.size(); s++) {
+    if (sizes[s] == 0) continue;
+
+    Operation op;
+    op.start_time = now;
+    op.key = groups[s];
+    op.type = Operation::GET;
+    op.keys = sizes[s];
+    op.origin = this;
+    op.parent = parent;
+    peers[s]->send_get(op);
+  }
+}
+
+/**
+ * Issue one of the --mix commands other than get and set.  A cas is a
+ * read-modify-write: a gets for the token, then a cas with it, retried
+ * from the gets when another client changed the item in between.
+ */
+template <class P>
+void ConnectionT<P>::issue_command(Operation::type_enum type,
+                                   const char* key, double now) {
+  Operation op;
+
+  if (now == 0.0) op.start_time = get_time();
+  else op.start_time = now;
+
+  op.key = string(key);
+  op.type = type;
+  op.origin = this;
+
+  if (type == Operation::CAS) {
+    op.type = Operation::GETS;
+    op.rmw = true;
+  }
+  if (type == Operation::APPEND || type == Operation::PREPEND ||
+      type == Operation::CAS)
+    op.value = rng.below(1024 * 1024);
+
+  outstanding++;
+  peers[route(key)]->send_command(op);
+}
+
+// The backend has answered a miss: store the value.
+template <class P>
+void ConnectionT<P>::fetch_callback(fetch_t* fetch) {
+  Operation &op = fetch->op;
+  int index = rng.below(1024 * 1024);
+
+  fetches.erase(fetch);
+  event_free(fetch->timer);
+
+  op.type = Operation::SET;
+  op.refill = true;
+  op.exptime = ttl();
+  if (options.verify)
+    op.version = verify_issue(verify_slot(), op.key.c_str());
+  op.hedge_id = 0;
+  op.backup = false;
+  peers[route(op.key.c_str())]->send_set(op, &random_char[index],
+                                         value_size(op.key.c_str()));
+  delete fetch;
+}
+
+template <class P>
+void ConnectionT<P>::issue_set(const char* key, const char* value,
+                               int length, double now) {
+  Operation op;
+
+  if (now == 0.0) op.start_time = get_time();
+  else op.start_time = now;
+
+  op.key = string(key);
+  op.type = Operation::SET;
+  op.size_class = slab_class(key);
+  op.exptime = ttl();
+  op.origin = this;
+  if (options.verify) op.version = verify_issue(verify_slot(), key);
+
+  outstanding++;
+
+  if (!options.balance || peers.size() == 1) {
+    peers[route(key)]->send_set(op, value, length);
+    return;
+  }
+
+  // Replicated sets complete once every replica has stored the value.
+  op.parent = new Operation(op);
+  op.parent->pending = peers.size();
+  for (auto peer: peers) peer->send_set(op, value, length);
+}
+
+template <class P>
+void ConnectionT<P>::send_get(Operation& op) {
+  int l;
+
+  stats.log_send(server, queue_depth());
+  op.queue = queue_depth();
+
+  if (udp) {
+    udp->send_get(op);
+    return;
+  }
+
   op_queue.push(op);
 
   if (read_state == IDLE) read_state = WAITING_FOR_GET;
-  l = prot->get_request(key);
+  l = prot->get_request(op.key.c_str());
   if (read_state != LOADING) stats.tx_bytes += l;
 }
 
-void Connection::issue_set(const char* key, const char* value, int length,
-                           double now) {
+template <class P>
+void ConnectionT<P>::send_set(Operation& op, const char* value, int length) {
+  string header = value_header(op.key.c_str(), op.version, value, length);
+  int l;
+
+  stats.log_send(server, op_queue.size());
+  op.queue = op_queue.size();
+  stats.value_tx += length;
+
+  if (options.noreply) {
+    noreply_ops->push_back(op);
+    unfenced++;
+    origin(op)->issued_unfenced++;
+    stats.tx_bytes += prot->set_request(op.key.c_str(), value, length,
+                                        op.exptime, true, header);
+    if (unfenced >= options.noreply) issue_fence();
+    return;
+  }
+
+  op_queue.push(op);
+
+  if (read_state == IDLE) read_state = WAITING_FOR_SET;
+  l = prot->set_request(op.key.c_str(), value, length, op.exptime, false,
+                        header);
+  if (read_state != LOADING) stats.tx_bytes += l;
+}
+
+// Send any command but get, set and fence.
+template <class P>
+void ConnectionT<P>::send_command(Operation& op) {
+  int index = op.value;
+  const char *key = op.key.c_str();
+  int l = 0;
+
+  stats.log_send(server, op_queue.size());
+  op.queue = op_queue.size();
+  op_queue.push(op);
+  if (read_state == IDLE) update_read_state();
+
+  switch (op.type) {
+  case Operation::GETS: l = prot->gets_request(key); break;
+  case Operation::DELETE: l = prot->delete_request(key); break;
+  case Operation::INCR: l = prot->arith_request(key, false, 1); break;
+  case Operation::DECR: l = prot->arith_request(key, true, 1); break;
+  case Operation::TOUCH: l = prot->touch_request(key, 0); break;
+  case Operation::APPEND:
+  case Operation::PREPEND:
+    l = prot->concat_request(key, &random_char[index], CONCAT_LENGTH,
+                             op.type == Operation::PREPEND);
+    break;
+  case Operation::CAS:
+    l = prot->cas_request(key, &random_char[index], value_size(key), op.cas,
+                          value_header(key, op.version, &random_char[index],
+                                       value_size(key)));
+    stats.value_tx += value_size(key);
+    break;
+  default: die("Not implemented.");
+  }
+
+  stats.tx_bytes += l;
+}
+
+template <class P>
+void ConnectionT<P>::issue_fence(double now) {
   Operation op;
   int l;
 
   if (now == 0.0) op.start_time = get_time();
   else op.start_time = now;
 
-  op.type = Operation::SET;
+  // The fence covers the noreply sets sent since the previous one.
+  op.type = Operation::FENCE;
+  op.keys = unfenced;
+  // The loader's fences cover sets that are not in noreply_ops.
+  if (noreply_ops)
+    for (size_t i = noreply_ops->size() - unfenced; i < noreply_ops->size();
+         i++)
+      origin((*noreply_ops)[i])->issued_unfenced--;
+  unfenced = 0;
   op_queue.push(op);
 
   if (read_state == IDLE) read_state = WAITING_FOR_SET;
-  l = prot->set_request(key, value, length);
-  if (read_state != LOADING) stats.tx_bytes += l;
+  l = prot->fence_request();
+  if (read_state != LOADING) {
+    stats.tx_bytes += l;
+    stats.fences++;
+  }
 }
 
-void Connection::pop_op() {
+template <class P>
+void ConnectionT<P>::pop_op() {
   assert(op_queue.size() > 0);
 
   op_queue.pop();
 
   if (read_state == LOADING) return;
+  update_read_state();
+}
+
+template <class P>
+void ConnectionT<P>::update_read_state() {
   read_state = IDLE;
 
   if (op_queue.size() > 0) {
     Operation& op = op_queue.front();
     switch (op.type) {
-    case Operation::GET: read_state = WAITING_FOR_GET; break;
-    case Operation::SET: read_state = WAITING_FOR_SET; break;
-    default: die("Not implemented.");
+    case Operation::GET:
+    case Operation::GETS: read_state = WAITING_FOR_GET; break;
+    case Operation::SASL: die("Not implemented.");
+    default: read_state = WAITING_FOR_SET; break;
     }
   }
 }
 
-void Connection::finish_op(Operation *op) {
+template <class P>
+void ConnectionT<P>::finish_op(Operation *op) {
   double now;
   now = get_time();
   op->end_time = now;
 
-  switch (op->type) {
-  case Operation::GET: stats.log_get(*op); break;
-  case Operation::SET: stats.log_set(*op); break;
-  default: die("Not implemented.");
+  Operation done = std::move(*op);
+  pop_op();
+  if (tracer) trace_op(done);
+  if (done.type == Operation::FENCE) finish_fence(done);
+  else origin(done)->complete_op(done);
+  maybe_reconnect();
+}
+
+// Complete the noreply sets that were sent before fence.
+template <class P>
+void ConnectionT<P>::finish_fence(Operation& fence) {
+  for (int i = 0; i < fence.keys; i++) {
+    Operation op = std::move(noreply_ops->front());
+    noreply_ops->pop_front();
+    op.end_time = fence.end_time;
+    origin(op)->complete_op(op);
   }
+}
 
-  pop_op();
+// Called on the issuing connection once the server has answered op.
+template <class P>
+void ConnectionT<P>::complete_op(Operation& op) {
+  Operation *logical = &op;
+
+  if (op.parent) {
+    if (op.type == Operation::GET) stats.log_sub(op);
+    logical = op.parent;
+    logical->hits += op.hits;
+    logical->lost |= op.lost;
+    if (--logical->pending > 0) return;
+    logical->end_time = op.end_time;
+    logical->queue = op.queue;
+  }
+
+  if (op.hedge_id && !finish_hedge(op)) return;
+
+  // Gets issued from now on must see at least what this set stored.
+  if (options.verify && (logical->type == Operation::SET ||
+                         logical->type == Operation::CAS))
+    verify_done(verify_slot(), logical->key.c_str());
+
+  // Cache-aside: fetch what a single-key get missed from the backend, and
+  // log the access once the refill has been stored.
+  if (backend && logical == &op) {
+    if (op.type == Operation::GET && !op.hits && !op.lost && op.keys == 1) {
+      fetch_t *fetch = new fetch_t{this, op, NULL};
+      fetch->op.miss_time = op.end_time;
+      DIE_Z(fetch->timer = evtimer_new(base, backend_cb<P>, fetch));
+      fetches.insert(fetch);
+
+      struct timeval tv;
+      double_to_tv(backend->generate() / 1000000, &tv);
+      evtimer_add(fetch->timer, &tv);
+      return;
+    } else if (op.refill) {
+      op.type = Operation::GET;
+      op.hits = 0;
+      stats.log_miss((op.end_time - op.miss_time) * 1000000);
+    }
+  }
+
+  if (op.rmw) {
+    Operation next = op;
+    next.hits = 0;
+    next.conflict = false;
+
+    if (op.type == Operation::GETS && op.hits) {
+      next.type = Operation::CAS;
+      if (options.verify)
+        next.version = verify_issue(verify_slot(), op.key.c_str());
+      peers[route(op.key.c_str())]->send_command(next);
+      return;
+    } else if (op.type == Operation::CAS && op.conflict) {
+      stats.cas_retries++;
+      next.type = Operation::GETS;
+      next.cas = 0;
+      // The version of the cas that failed was never stored.
+      next.version = 0;
+      peers[route(op.key.c_str())]->send_command(next);
+      return;
+    }
+
+    op.type = Operation::CAS;
+  }
+
+  if (record && !logical->lost) record_op(*logical);
+
+  switch (logical->type) {
+  case Operation::GET:
+    if (logical->lost) break;
+    stats.log_get(*logical);
+    if (options.churn > 0.0 &&
+        (churned_at == 0.0 || logical->start_time >= churned_at + CHURN_SETTLE))
+      stats.log_stay(*logical);
+    break;
+  case Operation::SET: stats.log_set(*logical); break;
+  case Operation::FENCE:
+  case Operation::SASL: die("Not implemented.");
+  default: stats.log_command(*logical); break;
+  }
+
+  if (op.parent) delete op.parent;
+
+  outstanding--;
+  maybe_reconnect();
   drive_write_machine();
 }
 
-void Connection::event_callback(short events) {
+/**
+ * Account for an answer to a hedged get.  Returns false if the other copy
+ * has already answered, or if op is a lost copy that another copy may
+ * still answer, in which case op must not be logged.
+ */
+template <class P>
+bool ConnectionT<P>::finish_hedge(Operation& op) {
+  if (!op.backup && !op.lost) {
+    stats.log_nohedge(op);
+
+    if (options.hedge_percentile > 0.0 && ++hedge_samples % HEDGE_UPDATE == 0) {
+      hedge_threshold =
+        stats.nohedge_sampler.get_nth(options.hedge_percentile) / 1000000;
+      if (!evtimer_pending(hedge_timer, NULL)) schedule_hedge();
+    }
+  }
+
+  if (op.hedge_id < hedge_first) return false;
+
+  hedge_t &h = (*hedges)[op.hedge_id - hedge_first];
+  if (h.done) return false;
+
+  // A lost copy leaves the get to the other one, sent now if it was not
+  // yet: the get is only lost once no copy can answer it.
+  h.copies--;
+  if (op.lost) {
+    if (!h.hedged) send_backup(op.hedge_id, get_time());
+    if (h.copies > 0) return false;
+  }
+
+  h.done = true;
+  if (op.backup) {
+    stats.hedge_wins++;
+    op.start_time = h.start_time;
+  }
+
+  while (hedges->size() > 0 && hedges->front().done) {
+    hedges->pop_front();
+    hedge_first++;
+  }
+  if (hedge_next < hedge_first) hedge_next = hedge_first;
+
+  return true;
+}
+
+// Arm the hedge timer for the oldest get that has not been hedged yet.
+template <class P>
+void ConnectionT<P>::schedule_hedge() {
+  uint64_t end = hedge_first + hedges->size();
+
+  while (hedge_next < end && ((*hedges)[hedge_next - hedge_first].done ||
+                              (*hedges)[hedge_next - hedge_first].hedged))
+    hedge_next++;
+  if (hedge_next == end || hedge_threshold < 0.0) return;
+
+  double delay = (*hedges)[hedge_next - hedge_first].start_time +
+    hedge_threshold - get_time();
+  if (delay < 0.0) delay = 0.0;
+
+  struct timeval tv;
+  double_to_tv(delay, &tv);
+  evtimer_add(hedge_timer, &tv);
+}
+
+// Send backup copies of the gets that have been outstanding too long.
+template <class P>
+void ConnectionT<P>::hedge_callback() {
+  double now = get_time();
+  uint64_t end = hedge_first + hedges->size();
+
+  if (check_exit_condition(now)) return;
+
+  while (hedge_next < end) {
+    hedge_t &h = (*hedges)[hedge_next - hedge_first];
+
+    if (!h.done && !h.hedged) {
+      if (h.start_time + hedge_threshold > now) break;
+      send_backup(hedge_next, now);
+    }
+
+    hedge_next++;
+  }
+
+  schedule_hedge();
+}
+
+// Send the backup copy of hedged get id, unless its backup is churning.
+template <class P>
+void ConnectionT<P>::send_backup(uint64_t id, double now) {
+  hedge_t &h = (*hedges)[id - hedge_first];
+  h.hedged = true;
+  if (backups[h.server]->churning()) return;
+
+  Operation op;
+  op.start_time = now;
+  op.key = h.key;
+  op.type = Operation::GET;
+  op.size_class = slab_class(h.key.c_str());
+  op.origin = this;
+  op.hedge_id = id;
+  if (options.verify) op.version = verify_latest(verify_slot(), h.key.c_str());
+  op.backup = true;
+
+  h.copies++;
+  stats.hedges++;
+  backups[h.server]->send_get(op);
+}
+
+template <class P>
+void ConnectionT<P>::event_callback(short events) {
   if (events & BEV_EVENT_CONNECTED) {
-    int fd;
-    DIE_NE(fd = bufferevent_getfd(bev));
-    int one = 1;
-    DIE_NZ(setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, (void *) &one, sizeof(one)));
-    read_state = IDLE;
+    // A TLS bufferevent only reports itself connected after the handshake.
+    if (options.tls) {
+      stats.log_handshake((get_time() - connect_start) * 1000000);
+      stats.tls_handshakes++;
+      if (SSL_session_reused(bufferevent_openssl_get_ssl(bev)))
+        stats.tls_resumed++;
+    }
+
+    if (!is_unix()) {
+      int fd;
+      DIE_NE(fd = bufferevent_getfd(bev));
+      int one = 1;
+      DIE_NZ(setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, (void *) &one, sizeof(one)));
+    }
+    if (read_state == INIT_READ) connection_ready();
   } else if (events & BEV_EVENT_ERROR) {
     int err = bufferevent_socket_get_dns_error(bev);
     char buf[100];
@@ -147,6 +1117,11 @@ void Connection::event_callback(short events) {
       snprintf(buf, 100, "DNS error: %s", evutil_gai_strerror(err));
       die(buf);
     }
+    unsigned long tls_err = options.tls ? bufferevent_get_openssl_error(bev) : 0;
+    if (tls_err) {
+      snprintf(buf, 100, "TLS error: %s", ERR_error_string(tls_err, NULL));
+      die(buf);
+    }
     snprintf(buf, 100, "BEV_EVENT_ERROR: %s", strerror(errno));
     die(buf);
   } else if (events & BEV_EVENT_EOF) {
@@ -154,13 +1129,15 @@ void Connection::event_callback(short events) {
   }
 }
 
-void Connection::read_callback() {
+template <class P>
+void ConnectionT<P>::read_callback() {
   struct evbuffer *input = bufferevent_get_input(bev);
 
   Operation *op = NULL;
-  bool done, full_read;
+  bool done;
 
-  if (op_queue.size() == 0) die("Spurious read callback.");
+  if (op_queue.size() == 0 && read_state != CONN_SETUP)
+    die("Spurious read callback.");
 
   while (1) {
     if (op_queue.size() > 0) op = &op_queue.front();
@@ -169,53 +1146,52 @@ void Connection::read_callback() {
     case INIT_READ: die("event from uninitialized connection");
     case IDLE: return;
 
-    case WAITING_FOR_GET:
-      assert(op_queue.size() > 0);
-      full_read = prot->handle_response(input, done);
-      if (!full_read) {
-        return;
-      } else if (done) {
-        finish_op(op);
-      }
+    case CONN_SETUP:
+      if (!prot->setup_connection_r(input)) return;
+      connection_ready();
       break;
 
+    // One call site, so that the protocol's parser is inlined here.
+    case WAITING_FOR_GET:
     case WAITING_FOR_SET:
-      assert(op_queue.size() > 0);
-      if (!prot->handle_response(input, done)) return;
-      finish_op(op);
-      break;
-
     case LOADING:
       assert(op_queue.size() > 0);
-      if (!prot->handle_response(input, done)) return;
-      loader_completed++;
-      pop_op();
+      if (!prot->handle_response(input, op, done)) return;
 
-      if (loader_completed == options.records) {
-        read_state = IDLE;
+      if (read_state == WAITING_FOR_GET) {
+        if (done) finish_op(op);
+      } else if (read_state == WAITING_FOR_SET) {
+        finish_op(op);
       } else {
-        while (loader_issued < loader_completed + LOADER_CHUNK) {
-          if (loader_issued >= options.records) break;
-          char key[256];
-          int index = lrand48() % (1024 * 1024);
-          snprintf(key, 256, "%0*" PRIu64, options.keysize, (unsigned long)loader_issued);
-          issue_set(key, &random_char[index], options.valuesize);
-          loader_issued++;
+        pop_op();
+
+        if (loader_issued >= loader_end && op_queue.size() == 0) {
+          read_state = IDLE;
+        } else {
+          while (op_queue.size() < LOADER_DEPTH && loader_issued < loader_end)
+            issue_load_chunk();
         }
       }
-
       break;
     default: die("not implemented");
     }
   }
 }
 
-void Connection::write_callback() {}
+template <class P>
+void ConnectionT<P>::write_callback() {}
 
-void Connection::drive_write_machine(double now) {
+template <class P>
+void ConnectionT<P>::drive_write_machine(double now) {
   if (now == 0.0) now = get_time();
 
-  if (check_exit_condition(now)) return;
+  if (check_exit_condition(now) || churning()) return;
+
+  // Requests sent through a draining peer would keep it from ever
+  // draining, so wait until it is back.
+  if (crossing)
+    for (auto peer: peers)
+      if (peer->churning()) return;
 
   while (1) {
     switch (write_state) {
@@ -224,16 +1200,19 @@ void Connection::drive_write_machine(double now) {
       break;
 
     case ISSUING:
-      if (op_queue.size() >= (size_t) options.depth) {
+      if (outstanding >= options.depth) {
+        // Nothing would complete if every request were an unfenced set.
+        if (options.noreply && issued_unfenced == outstanding)
+          for (auto peer: peers) peer->fence_noreply();
         write_state = WAITING_FOR_OPQ;
         return;
       }
       issue_set_or_get(now);
-      stats.log_op(op_queue.size());
+      stats.log_op(outstanding);
       break;
 
     case WAITING_FOR_OPQ:
-      if (op_queue.size() >= (size_t) options.depth) return;
+      if (outstanding >= options.depth) return;
       write_state = ISSUING;
       break;
 
@@ -242,24 +1221,20 @@ void Connection::drive_write_machine(double now) {
   }
 }
 
-bool Connection::check_exit_condition(double now) {
-  if (read_state == INIT_READ) return false;
+template <class P>
+bool ConnectionT<P>::check_exit_condition(double now) {
+  if (!is_connected()) return false;
   if (now == 0.0) now = get_time();
   if (now > start_time + options.time) return true;
   return false;
 }
 
-void bev_event_cb(struct bufferevent *bev, short events, void *ptr) {
-  Connection* conn = (Connection*) ptr;
-  conn->event_callback(events);
+// The text protocol is the only one so far.  Another Protocol subclass
+// gets its own ConnectionT and is picked here.
+Connection* createConnection(struct event_base* base, struct evdns_base* evdns,
+                             string hostname, int port,
+                             const options_t& options, ConnectionStats& stats,
+                             uint64_t stream) {
+  return new ConnectionT<ProtocolMemcachedText>(base, evdns, hostname, port,
+                                                options, stats, stream);
 }
-
-void bev_read_cb(struct bufferevent *bev, void *ptr) {
-  Connection* conn = (Connection*) ptr;
-  conn->read_callback();
-}
-
-void bev_write_cb(struct bufferevent *bev, void *ptr) {
-  Connection* conn = (Connection*) ptr;
-  conn->write_callback();
-}
\ No newline at end of file
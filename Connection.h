@@ -2,7 +2,10 @@
 #define CONNECTION_H
 
 #include <string>
+#include <deque>
 #include <queue>
+#include <set>
+#include <vector>
 
 #include <event2/event.h>
 #include <event2/dns.h>
@@ -10,38 +13,103 @@
 
 #include "ConnectionOptions.h"
 #include "ConnectionStats.h"
+#include "Generator.h"
+#include "KeyRouter.h"
 #include "Operation.h"
 #include "Protocol.h"
+#include "Random.h"
+#include "Record.h"
+#include "UDPTransport.h"
 
 using namespace std;
 
-void bev_event_cb(struct bufferevent *bev, short events, void *ptr);
-void bev_read_cb(struct bufferevent *bev, void *ptr);
-void bev_write_cb(struct bufferevent *bev, void *ptr);
-
+/**
+ * A connection as main, the protocols and the transports see it.  The
+ * request engine is ConnectionT, compiled for one Protocol subclass so
+ * that the protocol's calls on the hot path are direct; the protocol is
+ * picked once, in createConnection().
+ */
 class Connection {
 public:
-  Connection(struct event_base* _base, struct evdns_base* _evdns, 
-             string _hostname, int _port, options_t _options);
-  ~Connection();
+  Connection(const options_t& _options, ConnectionStats& _stats) :
+    options(_options), stats(_stats), record(NULL) {}
+  virtual ~Connection() {}
 
   double start_time;
-  options_t options;
-  ConnectionStats stats;
+  const options_t& options;
+
+  // Shared by every connection of a thread, so that a connection costs
+  // little more than its socket buffers.  The options are the run's.
+  ConnectionStats& stats;
+
+  // The thread's --record ring, or NULL.
+  RecordRing *record;
+
+  virtual bool is_ready() = 0;
+  virtual void set_routing(KeyRouter* router, const vector<Connection*>& peers,
+                           int server) = 0;
+  virtual void set_backups(const vector<Connection*>& backups) = 0;
+  virtual void connect() = 0;
+  virtual void churn() = 0;
+  virtual void start() = 0;
+  virtual void start_loading(int from, int to) = 0;
+  virtual bool check_exit_condition(double now = 0.0) = 0;
+
+  virtual void complete_op(Operation& op) = 0;
+};
+
+Connection* createConnection(struct event_base* base, struct evdns_base* evdns,
+                             string hostname, int port,
+                             const options_t& options, ConnectionStats& stats,
+                             uint64_t stream);
+
+template <class P>
+class ConnectionT final : public Connection {
+public:
+  ConnectionT(struct event_base* _base, struct evdns_base* _evdns,
+              string _hostname, int _port, const options_t& _options,
+              ConnectionStats& _stats, uint64_t stream);
+  ~ConnectionT();
 
   bool is_ready() { return read_state == IDLE; }
+  bool is_connected() {
+    return read_state != INIT_READ && read_state != CONN_SETUP;
+  }
+  // Requests this connection waits for, over TCP and UDP alike.
+  size_t queue_depth() {
+    return op_queue.size() + (udp ? udp->outstanding() : 0);
+  }
+  void set_routing(KeyRouter* _router, const vector<Connection*>& _peers,
+                   int _server);
+  void set_backups(const vector<Connection*>& _backups);
+  void connect();
+  void churn();
   void start() { drive_write_machine(); }
-  void start_loading();
+  void start_loading(int from, int to);
   void reset();
   bool check_exit_condition(double now = 0.0);
 
   void event_callback(short events);
   void read_callback();
   void write_callback();
+  void hedge_callback();
+  void reconnect_callback();
+
+  void complete_op(Operation& op);
+
+  // A --backend fetch for a get that missed, waiting for its timer.
+  struct fetch_t {
+    ConnectionT *conn;
+    Operation op;
+    struct event *timer;
+  };
+
+  void fetch_callback(fetch_t* fetch);
 
 private:
   string hostname;
   int port;
+  bool is_unix() { return !hostname.compare(0, 5, "unix:"); }
 
   struct event_base *base;
   struct evdns_base *evdns;
@@ -49,6 +117,7 @@ private:
 
   enum read_state_enum {
     INIT_READ,
+    CONN_SETUP,
     LOADING,
     IDLE,
     WAITING_FOR_GET,
@@ -67,18 +136,128 @@ private:
   read_state_enum read_state;
   write_state_enum write_state;  
 
-  int loader_issued, loader_completed;
+  int loader_issued, loader_end;
+
+  // Churn: a draining connection issues nothing new and reconnects once
+  // every request it issued or carries has been answered, and its peers
+  // wait for it.  Gets sent less than CHURN_SETTLE after the last
+  // reconnect are not part of the "stay" row.
+  bool draining, reconnecting;
+  bool churning() { return draining || reconnecting; }
+  double churned_at;
+  double connect_start;
 
-  Protocol *prot;
+  P *prot;
+  UDPTransport *udp;
+
+  // Noreply sets sent through this connection, oldest first, that wait for
+  // a fence.  The newest unfenced of them are not covered by one yet.
+  // NULL without --noreply, as an empty deque still takes a block.
+  deque<Operation> *noreply_ops;
+  int unfenced;
+
+  // Noreply sets this connection issued that no fence covers yet.
+  int issued_unfenced;
+
+  // Every random choice of the connection comes from rng, drawn from
+  // stream of the seed.
+  uint64_t stream;
+  Random rng;
+  Generator *backend;
+  set<fetch_t*> fetches;
+  Generator *popularity;
+  Generator *expiry;
   queue<Operation> op_queue;
 
+  // Keys are sent to peers[route(key)]; without a router every key is
+  // owned by this connection's own server.
+  KeyRouter *router;
+  vector<ConnectionT*> peers;
+  int server;
+
+  // Whether requests can go through peers: with a router, fan-outs or
+  // replicas.
+  bool crossing;
+  int outstanding;
+  unsigned int next_replica;
+
+  // Single-key gets that may still need a backup copy, in issue order.
+  // The entry for hedge id i is hedges[i - hedge_first].  copies counts
+  // the copies that may still answer.
+  struct hedge_t {
+    double start_time;
+    string key;
+    int server;
+    int copies;
+    bool hedged, done;
+  };
+
+  vector<ConnectionT*> backups;
+  struct event *hedge_timer;
+  deque<hedge_t> *hedges;  // NULL without --hedge.
+  uint64_t hedge_first, hedge_next;
+  uint64_t hedge_samples;
+  double hedge_threshold;
+
+  // --trace-slow thresholds by command in microseconds, and the latest
+  // requests answered on this connection.  NULL without the option.
+  struct tracer_t {
+    double threshold[Operation::COMMANDS];
+    uint64_t samples;
+    answered_t answered[TRACE_AHEAD];
+    uint64_t next;
+  };
+  tracer_t *tracer;
+
+  // Every connection of a run speaks the same protocol.
+  static ConnectionT* origin(const Operation& op) {
+    return static_cast<ConnectionT*>(op.origin);
+  }
+
+  int route(const char* key) { return router ? router->route(key) : server; }
+  int pick_replica();
+  void random_key(char* key);
+  void random_get_key(char* key);
+  void counter_key(char* key);
+  int ttl();
+  int slab_class(const char* key);
+  int value_size(const char* key);
+  void record_op(const Operation& op);
+  void trace_op(const Operation& op);
+  static uint64_t key_index(const char* key);
+  string value_header(const char* key, uint64_t version, const char* value,
+                      int length);
+
+  // Versions are kept per server when every server has its own keys.
+  int verify_slot() { return router || options.balance ? 0 : server; }
+
+  void connection_ready();
+  void maybe_reconnect();
+  void update_read_state();
   void pop_op();
   void finish_op(Operation *op);
+  bool finish_hedge(Operation& op);
+  void send_backup(uint64_t id, double now);
+  void schedule_hedge();
   void drive_write_machine(double now = 0.0);
 
   void issue_get(const char* key, double now = 0.0);
+  void issue_multiget(int count, double now = 0.0);
+  void issue_fanout(int count, double now = 0.0);
+  void issue_split_get(vector<string>& groups, vector<int>& sizes,
+                       double now);
   void issue_set(const char* key, const char* value, int length, double now = 0.0);
+  void issue_command(Operation::type_enum type, const char* key,
+                     double now = 0.0);
   void issue_set_or_get(double now = 0.0);
+
+  void send_get(Operation& op);
+  void send_set(Operation& op, const char* value, int length);
+  void send_command(Operation& op);
+  void issue_fence(double now = 0.0);
+  void fence_noreply() { if (unfenced > 0) issue_fence(); }
+  void finish_fence(Operation& fence);
+  void issue_load_chunk();
 };
 
 #endif
\ No newline at end of file
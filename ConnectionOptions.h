@@ -1,14 +1,81 @@
 #ifndef CONNECTIONOPTIONS_H
 #define CONNECTIONOPTIONS_H
 
+#include <inttypes.h>
+
+#include "Operation.h"
+
+#define MAX_SLAB_CLASSES 63
+
+enum balance_enum {
+  BALANCE_NONE, BALANCE_RANDOM, BALANCE_ROUNDROBIN, BALANCE_LEAST, BALANCE_P2C
+};
+
 typedef struct {
   int time;
+  uint64_t seed;
   int keysize;
   int valuesize;
   int records;
+
+  // memcached's id and chunk size of each --slab-classes class, and the
+  // value length that fills it.
+  int slab_classes;
+  int slab_id[MAX_SLAB_CLASSES];
+  int slab_chunk[MAX_SLAB_CLASSES];
+  int slab_value[MAX_SLAB_CLASSES];
+  int keyspace;
+  double hit_ratio;
+  double zipf;
+  double hot_drift;
+  double hot_jump;
+  double report;
+
+  // Set expiration times, and the time at which the storm fraction of the
+  // loaded records all expire.
+  bool ttl;
+  char ttl_dist[64];
+  double storm_at;
+  double storm_fraction;
   double ratio;
   int connections;
   int depth;
+  int multiget;
+  int fanout;
+  balance_enum balance;
+  int noreply;
+
+  // Cache-aside: a missed get fetches from a backend that takes this long
+  // and then sets the key.
+  bool cache_aside;
+  char backend[64];
+
+  // Cumulative share of each command with --mix, and whether the mix has
+  // counters that need numeric values loaded.
+  bool mix;
+  double mix_cdf[Operation::COMMANDS];
+  bool counters;
+
+  bool hedge;
+  double hedge_after;
+  double hedge_percentile;
+
+  // --trace-slow: a fixed threshold in microseconds, or a percentile.
+  bool trace;
+  double trace_after;
+  double trace_percentile;
+  int threads;
+  double ramp;
+  double churn;
+
+  bool verify;
+  bool udp;
+  bool tls;
+  bool sasl;
+  char username[32];
+  char password[32];
+
+  bool noload;
 } options_t;
 
 #endif
\ No newline at end of file
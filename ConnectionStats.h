@@ -3,29 +3,240 @@
 
 #include <inttypes.h>
 
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
 #include "LogSampler.h"
+#include "config.h"
 
 using namespace std;
 
+// What happened during one --report interval.
+struct interval_t {
+  interval_t() : get_sampler(200), ops(0), get_keys(0), get_misses(0) {}
+
+  LogSampler get_sampler;
+  uint64_t ops, get_keys, get_misses;
+
+  // Zeros for an interval without gets, e.g. a stalled one.
+  double hit_percent() {
+    return get_keys ? 100 - (double) get_misses / get_keys * 100 : 0.0;
+  }
+  double get_average() {
+    return get_sampler.total() ? get_sampler.average() : 0.0;
+  }
+  double get_nth(double nth) {
+    return get_sampler.total() ? get_sampler.get_nth(nth) : 0.0;
+  }
+
+  void accumulate(const interval_t &i) {
+    get_sampler.accumulate(i.get_sampler);
+    ops += i.ops;
+    get_keys += i.get_keys;
+    get_misses += i.get_misses;
+  }
+};
+
+// A request answered on a connection, by the index of its key.
+struct answered_t {
+  int type;
+  uint64_t key;
+  double start_time, end_time;
+};
+
+// A request slower than --trace-slow.
+struct trace_t {
+  double start_time, end_time;
+  int type;
+  string key;
+  int keys, hits, size;
+
+  // server * MAXIMUM_CONNECTIONS + connection, the requests ahead of it
+  // when it was sent, and those sent after it still unanswered when it
+  // was answered.
+  uint64_t connection;
+  int queue, behind;
+
+  // The requests answered just before it on its connection that were
+  // already sent when it was, newest first.
+  vector<answered_t> ahead;
+
+  double time() const { return (end_time - start_time) * 1000000; }
+
+  // Orders a heap with the fastest trace on top.
+  static bool slower(const trace_t& a, const trace_t& b) {
+    return a.time() > b.time();
+  }
+};
+
 class ConnectionStats {
 public:
-  ConnectionStats() : get_sampler(200), set_sampler(200), op_sampler(100),
-    rx_bytes(0), tx_bytes(0), gets(0), sets(0), get_misses(0), skips(0) {}
+  ConnectionStats() : get_sampler(200), set_sampler(200), sub_sampler(200),
+    nohedge_sampler(200), stay_sampler(200), connect_sampler(200),
+    handshake_sampler(200), miss_sampler(200),
+    cmd_samplers(Operation::COMMANDS, LogSampler(200)),
+    cmd_ops(Operation::COMMANDS, 0), cmd_misses(Operation::COMMANDS, 0),
+    cas_retries(0), refills(0), report(0.0),
+    op_sampler(100),
+    rx_bytes(0), tx_bytes(0), value_rx(0), value_tx(0), gets(0), sets(0), get_keys(0), get_misses(0),
+    skips(0), hedges(0), hedge_wins(0), reconnects(0),
+    udp_gets(0), udp_lost(0), udp_reordered(0), udp_late(0),
+    tls_handshakes(0), tls_resumed(0), fences(0),
+    verified(0), corrupt(0), stale(0), recorded(0), record_dropped(0),
+    slow(0),
+    loaded(0), loaded_bytes(0), connect_time(0.0), load_start(0.0), load_stop(0.0),
+    cpu_user(0.0), cpu_sys(0.0) {}
   
   LogSampler get_sampler;
   LogSampler set_sampler;
+  LogSampler sub_sampler;
+  LogSampler nohedge_sampler;
+  LogSampler stay_sampler;
+  LogSampler connect_sampler;
+  LogSampler handshake_sampler;
+  LogSampler miss_sampler;
+
+  // Commands of --mix other than get and set, indexed by type.
+  vector<LogSampler> cmd_samplers;
+  vector<uint64_t> cmd_ops, cmd_misses;
+  uint64_t cas_retries;
+  uint64_t refills;
+
+  // Gets and sets by the slab class of their value, and the gets that hit.
+  vector<LogSampler> class_get_samplers, class_set_samplers;
+  vector<uint64_t> class_hits;
+
+  // Operations by the --report interval they completed in, counted from
+  // start.
+  double report;
+  vector<interval_t> intervals;
   LogSampler op_sampler;
   
   uint64_t rx_bytes, tx_bytes;  
-  uint64_t gets, sets, get_misses;
+  uint64_t value_rx, value_tx;
+  uint64_t gets, sets, get_keys, get_misses;
   uint64_t skips;
+  uint64_t hedges, hedge_wins;
+  uint64_t reconnects;
+  uint64_t udp_gets, udp_lost, udp_reordered, udp_late;
+  uint64_t tls_handshakes, tls_resumed;
+  uint64_t fences;
+  uint64_t verified, corrupt, stale;
+  uint64_t recorded, record_dropped;
+
+  // Requests slower than --trace-slow, by connection, and the
+  // TRACE_SLOWEST slowest of them.
+  uint64_t slow;
+  map<uint64_t, uint64_t> slow_connections;
+  vector<trace_t> traces;
+
+  // Requests sent to each server, and the sum of the server connection's
+  // queue depth when they were sent.
+  vector<uint64_t> server_ops, server_depth;
+  uint64_t loaded, loaded_bytes;
 
   double start, stop;
+  double connect_time;
+  double load_start, load_stop;
+
+  // CPU time the client's threads spent during the measurement.
+  double cpu_user, cpu_sys;
+
+  interval_t* interval(const Operation& op) {
+    if (report <= 0.0 || op.end_time < start) return NULL;
+
+    size_t i = (op.end_time - start) / report;
+    if (i >= intervals.size()) intervals.resize(i + 1);
+    intervals[i].ops++;
+    return &intervals[i];
+  }
+
+  void log_get(Operation& op) {
+    get_sampler.sample(op);
+    gets++;
+    get_keys += op.keys;
+    get_misses += op.keys - op.hits;
 
-  void log_get(Operation& op) { get_sampler.sample(op); gets++; }
-  void log_set(Operation& op) { set_sampler.sample(op); sets++; }
+    if (interval_t *i = interval(op)) {
+      i->get_sampler.sample(op);
+      i->get_keys += op.keys;
+      i->get_misses += op.keys - op.hits;
+    }
+
+    if (op.size_class >= 0) {
+      grow_classes(op.size_class);
+      class_get_samplers[op.size_class].sample(op);
+      class_hits[op.size_class] += op.hits;
+    }
+  }
+
+  void log_set(Operation& op) {
+    set_sampler.sample(op);
+    sets++;
+    interval(op);
+
+    if (op.size_class >= 0) {
+      grow_classes(op.size_class);
+      class_set_samplers[op.size_class].sample(op);
+    }
+  }
+
+  void grow_classes(size_t c) {
+    if (class_hits.size() > c) return;
+    class_get_samplers.resize(c + 1, LogSampler(200));
+    class_set_samplers.resize(c + 1, LogSampler(200));
+    class_hits.resize(c + 1, 0);
+  }
+
+  void log_sub(Operation& op) { sub_sampler.sample(op); }
+  void log_nohedge(Operation& op) { nohedge_sampler.sample(op); }
+  void log_stay(Operation& op) { stay_sampler.sample(op); }
+  void log_connect(double us) { connect_sampler.sample(us); }
+  void log_handshake(double us) { handshake_sampler.sample(us); }
+  void log_miss(double us) { miss_sampler.sample(us); refills++; }
+
+  void log_command(Operation& op) {
+    cmd_samplers[op.type].sample(op);
+    cmd_ops[op.type]++;
+    if (!op.hits) cmd_misses[op.type]++;
+    interval(op);
+  }
   void log_op (double op)     { op_sampler.sample(op); }
 
+  void log_slow(const trace_t& t) {
+    slow++;
+    slow_connections[t.connection]++;
+    keep_trace(t);
+  }
+
+  void keep_trace(const trace_t& t) {
+    if (traces.size() < TRACE_SLOWEST) {
+      traces.push_back(t);
+      push_heap(traces.begin(), traces.end(), trace_t::slower);
+    } else if (t.time() > traces.front().time()) {
+      pop_heap(traces.begin(), traces.end(), trace_t::slower);
+      traces.back() = t;
+      push_heap(traces.begin(), traces.end(), trace_t::slower);
+    }
+  }
+
+  void log_send(int server, size_t depth) {
+    if (server_ops.size() <= (size_t) server) {
+      server_ops.resize(server + 1, 0);
+      server_depth.resize(server + 1, 0);
+    }
+    server_ops[server]++;
+    server_depth[server] += depth;
+  }
+
+  uint64_t sent() {
+    uint64_t sum = 0;
+    for (auto i: server_ops) sum += i;
+    return sum;
+  }
+
   double get_qps() {
     return (gets + sets) / (stop - start);
   }
@@ -37,17 +248,80 @@ public:
   void accumulate(const ConnectionStats &cs) {
     get_sampler.accumulate(cs.get_sampler);
     set_sampler.accumulate(cs.set_sampler);
+    sub_sampler.accumulate(cs.sub_sampler);
+    nohedge_sampler.accumulate(cs.nohedge_sampler);
+    stay_sampler.accumulate(cs.stay_sampler);
+    connect_sampler.accumulate(cs.connect_sampler);
+    handshake_sampler.accumulate(cs.handshake_sampler);
+    miss_sampler.accumulate(cs.miss_sampler);
+    refills += cs.refills;
+    for (int i = 0; i < Operation::COMMANDS; i++) {
+      cmd_samplers[i].accumulate(cs.cmd_samplers[i]);
+      cmd_ops[i] += cs.cmd_ops[i];
+      cmd_misses[i] += cs.cmd_misses[i];
+    }
+    cas_retries += cs.cas_retries;
+    if (cs.class_hits.size()) grow_classes(cs.class_hits.size() - 1);
+    for (size_t i = 0; i < cs.class_hits.size(); i++) {
+      class_get_samplers[i].accumulate(cs.class_get_samplers[i]);
+      class_set_samplers[i].accumulate(cs.class_set_samplers[i]);
+      class_hits[i] += cs.class_hits[i];
+    }
+
+    report = cs.report;
+    if (intervals.size() < cs.intervals.size())
+      intervals.resize(cs.intervals.size());
+    for (size_t i = 0; i < cs.intervals.size(); i++)
+      intervals[i].accumulate(cs.intervals[i]);
     op_sampler.accumulate(cs.op_sampler);
 
     rx_bytes += cs.rx_bytes;
     tx_bytes += cs.tx_bytes;
+    value_rx += cs.value_rx;
+    value_tx += cs.value_tx;
     gets += cs.gets;
     sets += cs.sets;
+    get_keys += cs.get_keys;
     get_misses += cs.get_misses;
     skips += cs.skips;
+    hedges += cs.hedges;
+    hedge_wins += cs.hedge_wins;
+    reconnects += cs.reconnects;
+    cpu_user += cs.cpu_user;
+    cpu_sys += cs.cpu_sys;
+    udp_gets += cs.udp_gets;
+    udp_lost += cs.udp_lost;
+    udp_reordered += cs.udp_reordered;
+    udp_late += cs.udp_late;
+    tls_handshakes += cs.tls_handshakes;
+    tls_resumed += cs.tls_resumed;
+    fences += cs.fences;
+    verified += cs.verified;
+    corrupt += cs.corrupt;
+    stale += cs.stale;
+    recorded += cs.recorded;
+    record_dropped += cs.record_dropped;
+    slow += cs.slow;
+    for (auto &c: cs.slow_connections) slow_connections[c.first] += c.second;
+    for (auto &t: cs.traces) keep_trace(t);
+
+    if (server_ops.size() < cs.server_ops.size()) {
+      server_ops.resize(cs.server_ops.size(), 0);
+      server_depth.resize(cs.server_ops.size(), 0);
+    }
+    for (size_t i = 0; i < cs.server_ops.size(); i++) {
+      server_ops[i] += cs.server_ops[i];
+      server_depth[i] += cs.server_depth[i];
+    }
+    loaded += cs.loaded;
+    loaded_bytes += cs.loaded_bytes;
+
+    if (cs.connect_time > connect_time) connect_time = cs.connect_time;
 
     start = cs.start;
     stop = cs.stop;
+    load_start = cs.load_start;
+    load_stop = cs.load_stop;
   }
 
   void print_header() {
@@ -0,0 +1,29 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "Generator.h"
+#include "util.h"
+
+Generator* createGenerator(string str) {
+  const char *s = str.c_str();
+  const char *args = strchr(s, ':');
+  double a = 0.0, b = 0.0, c = 0.0;
+
+  if (args == NULL && sscanf(s, "%lf", &a) == 1) return new Fixed(a);
+
+  if (args) {
+    string name(s, args - s);
+    sscanf(args + 1, "%lf,%lf,%lf", &a, &b, &c);
+
+    if (name == "fixed") return new Fixed(a);
+    if (name == "uniform") return new Uniform(a);
+    if (name == "normal") return new Normal(a, b);
+    if (name == "exponential") return new Exponential(a);
+    if (name == "pareto") return new GPareto(a, b, c);
+  }
+
+  char buf[100];
+  snprintf(buf, 100, "Unknown distribution: %s", s);
+  die(buf);
+  return NULL;
+}
@@ -0,0 +1,147 @@
+/* -*- c++ -*- */
+#ifndef GENERATOR_H
+#define GENERATOR_H
+
+#include <inttypes.h>
+#include <math.h>
+#include <stdlib.h>
+
+#include <string>
+
+#include "Random.h"
+
+using namespace std;
+
+// A random distribution.  generate() draws from it with the uniform
+// variate U, or with a fresh one from rng (drand48() until one is set)
+// when U is not given.
+class Generator {
+public:
+  Generator() : rng(NULL) {}
+  virtual ~Generator() {}
+
+  virtual double generate(double U = -1.0) = 0;
+  void set_random(Random* _rng) { rng = _rng; }
+
+protected:
+  Random *rng;
+
+  double uniform(double U) {
+    if (U >= 0.0) return U;
+    return rng ? rng->uniform() : drand48();
+  }
+};
+
+class Fixed : public Generator {
+public:
+  Fixed(double _value) : value(_value) {}
+  virtual double generate(double U = -1.0) { return value; }
+
+private:
+  double value;
+};
+
+class Uniform : public Generator {
+public:
+  Uniform(double _scale) : scale(_scale) {}
+  virtual double generate(double U = -1.0) { return uniform(U) * scale; }
+
+private:
+  double scale;
+};
+
+// Box-Muller, truncated at 0.
+class Normal : public Generator {
+public:
+  Normal(double _mean, double _sd) : mean(_mean), sd(_sd) {}
+
+  virtual double generate(double U = -1.0) {
+    double V = uniform(-1.0);
+    double x = mean + sd * sqrt(-2 * log(1 - uniform(U))) * cos(2 * M_PI * V);
+    return x < 0.0 ? 0.0 : x;
+  }
+
+private:
+  double mean, sd;
+};
+
+class Exponential : public Generator {
+public:
+  Exponential(double _mean) : mean(_mean) {}
+  virtual double generate(double U = -1.0) { return -mean * log(1 - uniform(U)); }
+
+private:
+  double mean;
+};
+
+// Generalized Pareto with location, scale and shape.
+class GPareto : public Generator {
+public:
+  GPareto(double _loc, double _scale, double _shape) :
+    loc(_loc), scale(_scale), shape(_shape) {}
+
+  virtual double generate(double U = -1.0) {
+    double u = 1 - uniform(U);
+    if (shape == 0.0) return loc - scale * log(u);
+    return loc + scale * (pow(u, -shape) - 1) / shape;
+  }
+
+private:
+  double loc, scale, shape;
+};
+
+/**
+ * Zipf ranks 0..n-1 with exponent s > 0, by Hormann and Derflinger's
+ * rejection-inversion, which needs no table however large n is.
+ */
+class Zipf : public Generator {
+public:
+  Zipf(uint64_t _n, double _s) : n(_n), s(_s) {
+    h_x1 = H(1.5) - 1;
+    h_n = H(n + 0.5);
+    cut = 2 - H_inverse(H(2.5) - h(2));
+  }
+
+  virtual double generate(double U = -1.0) {
+    while (1) {
+      double u = h_n + uniform(U) * (h_x1 - h_n);
+      double x = H_inverse(u);
+      uint64_t k = x + 0.5;
+      if (k < 1) k = 1;
+      else if (k > n) k = n;
+
+      if (k - x <= cut || u >= H(k + 0.5) - h(k)) return k - 1;
+      U = -1.0;
+    }
+  }
+
+private:
+  uint64_t n;
+  double s;
+  double h_x1, h_n, cut;
+
+  double h(double x) { return exp(-s * log(x)); }
+  double H(double x) { return helper2((1 - s) * log(x)) * log(x); }
+
+  double H_inverse(double x) {
+    double t = x * (1 - s);
+    if (t < -1) t = -1;
+    return exp(helper1(t) * x);
+  }
+
+  // log1p(x) / x and expm1(x) / x, accurate near 0.
+  static double helper1(double x) {
+    return fabs(x) > 1e-8 ? log1p(x) / x : 1 - x * (0.5 - x * (1.0 / 3 - 0.25 * x));
+  }
+  static double helper2(double x) {
+    return fabs(x) > 1e-8 ? expm1(x) / x : 1 + x * 0.5 * (1 + x / 3 * (1 + 0.25 * x));
+  }
+};
+
+/**
+ * Parse a distribution: a plain number or fixed:X, uniform:MAX,
+ * normal:MEAN,SD, exponential:MEAN or pareto:LOC,SCALE,SHAPE.
+ */
+Generator* createGenerator(string str);
+
+#endif
@@ -0,0 +1,100 @@
+#include <stdio.h>
+#include <string.h>
+
+#include <openssl/evp.h>
+
+#include <algorithm>
+
+#include "KeyRouter.h"
+#include "util.h"
+
+// FNV-1a followed by the murmur3 finalizer, so that keys differing only in
+// their last digits still spread over the whole 64-bit range.
+uint64_t hash_key(const char *key) {
+  uint64_t h = 14695981039346656037ULL;
+
+  for (const char *p = key; *p; p++) {
+    h ^= (unsigned char) *p;
+    h *= 1099511628211ULL;
+  }
+
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+
+  return h;
+}
+
+// libketama takes its points from MD5 digests, four little-endian words
+// to a digest.
+static void ketama_md5(const char *s, unsigned char *digest) {
+  if (!EVP_Digest(s, strlen(s), digest, NULL, EVP_md5(), NULL))
+    die("MD5 failed");
+}
+
+static uint32_t ketama_word(const unsigned char *digest, int w) {
+  return (uint32_t) digest[w * 4 + 3] << 24 | digest[w * 4 + 2] << 16 |
+    digest[w * 4 + 1] << 8 | digest[w * 4];
+}
+
+// The continuum of libketama with equal weights: "host:port-i" for each of
+// the server's KETAMA_POINTS / 4 digests.
+KeyRouterKetama::KeyRouterKetama(const vector<pair<string, int>>& servers) :
+  KeyRouter(servers.size())
+{
+  unsigned char digest[EVP_MAX_MD_SIZE];
+
+  for (size_t s = 0; s < servers.size(); s++) {
+    for (int i = 0; i < KETAMA_POINTS / 4; i++) {
+      char point[300];
+      snprintf(point, 300, "%s:%d-%d", servers[s].first.c_str(),
+               servers[s].second, i);
+      ketama_md5(point, digest);
+      for (int w = 0; w < 4; w++)
+        continuum.push_back({ketama_word(digest, w), (int) s});
+    }
+  }
+
+  sort(continuum.begin(), continuum.end());
+}
+
+// The first point at or after the key's, as ketama_get_server() finds it.
+int KeyRouterKetama::route(const char *key) {
+  unsigned char digest[EVP_MAX_MD_SIZE];
+  ketama_md5(key, digest);
+  uint32_t h = ketama_word(digest, 0);
+
+  auto it = lower_bound(continuum.begin(), continuum.end(),
+                        make_pair(h, 0));
+  if (it == continuum.end()) it = continuum.begin();
+
+  return it->second;
+}
+
+// Lamping and Veach, "A Fast, Minimal Memory, Consistent Hash Algorithm".
+int KeyRouterJump::route(const char *key) {
+  uint64_t h = hash_key(key);
+  int64_t b = -1, j = 0;
+
+  while (j < servers) {
+    b = j;
+    h = h * 2862933555777941757ULL + 1;
+    j = (b + 1) * ((double) (1LL << 31) / (double) ((h >> 33) + 1));
+  }
+
+  return b;
+}
+
+KeyRouter* createKeyRouter(const char *method,
+                           const vector<pair<string, int>>& servers) {
+  if (!strcmp(method, "none")) return NULL;
+  if (!strcmp(method, "ketama")) return new KeyRouterKetama(servers);
+  if (!strcmp(method, "jump")) return new KeyRouterJump(servers.size());
+
+  char buf[100];
+  snprintf(buf, 100, "Unknown --hash method: %s", method);
+  die(buf);
+  return NULL;
+}
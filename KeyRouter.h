@@ -0,0 +1,49 @@
+/* -*- c++ -*- */
+#ifndef KEYROUTER_H
+#define KEYROUTER_H
+
+#include <inttypes.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+#define KETAMA_POINTS 160
+
+uint64_t hash_key(const char *key);
+
+// Maps a key to the index of the server that owns it.
+class KeyRouter {
+public:
+  KeyRouter(int _servers) : servers(_servers) {}
+  virtual ~KeyRouter() {}
+
+  virtual int route(const char *key) = 0;
+
+protected:
+  int servers;
+};
+
+class KeyRouterKetama : public KeyRouter {
+public:
+  KeyRouterKetama(const vector<pair<string, int>>& servers);
+
+  virtual int route(const char *key);
+
+private:
+  vector<pair<uint32_t, int>> continuum;
+};
+
+class KeyRouterJump : public KeyRouter {
+public:
+  KeyRouterJump(int servers) : KeyRouter(servers) {}
+
+  virtual int route(const char *key);
+};
+
+KeyRouter* createKeyRouter(const char *method,
+                           const vector<pair<string, int>>& servers);
+
+#endif
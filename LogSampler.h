@@ -17,13 +17,12 @@ class LogSampler {
 public:
   std::vector<uint64_t> bins;
 
-  std::vector<Operation> samples;
-
   double sum;
   double sum_sq;
+  double max;
 
   LogSampler() = delete;
-  LogSampler(int _bins) : sum(0.0), sum_sq(0.0) {
+  LogSampler(int _bins) : sum(0.0), sum_sq(0.0), max(0.0) {
     assert(_bins > 0);
 
     bins.resize(_bins + 1, 0);
@@ -39,6 +38,7 @@ public:
 
     sum += s;
     sum_sq += s*s;
+    if (s > max) max = s;
 
     if ((int64_t) bin < 0) {
       bin = 0;
@@ -97,8 +97,7 @@ public:
 
     sum += h.sum;
     sum_sq += h.sum_sq;
-
-    for (auto i: h.samples) samples.push_back(i);
+    if (h.max > max) max = h.max;
   }
 };
 
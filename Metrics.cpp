@@ -0,0 +1,207 @@
+#include <math.h>
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+
+#include <vector>
+
+#include <event2/buffer.h>
+#include <event2/event.h>
+#include <event2/http.h>
+
+#include "Metrics.h"
+#include "util.h"
+
+static vector<MetricsSlot> slots;
+static pthread_t metrics_thread;
+static struct event_base *metrics_base = NULL;
+static struct evhttp *metrics_http = NULL;
+static bool stopping = false;
+
+// The newest snapshot at the previous scrape, for the QPS gauge.
+static uint64_t last_ops = 0, last_us = 0;
+static double last_qps = 0.0;
+
+#define WORDS (sizeof(metrics_t) / sizeof(uint64_t))
+
+void MetricsSlot::publish(ConnectionStats& stats, double now) {
+  metrics_t m = metrics_t();
+
+  m.start_us = stats.start * 1000000;
+  m.time_us = now * 1000000;
+  m.gets = stats.gets;
+  m.sets = stats.sets;
+  for (auto ops: stats.cmd_ops) m.commands += ops;
+  m.get_keys = stats.get_keys;
+  m.get_misses = stats.get_misses;
+  m.rx_bytes = stats.rx_bytes;
+  m.tx_bytes = stats.tx_bytes;
+  m.get_sum_ns = stats.get_sampler.sum * 1000;
+  m.set_sum_ns = stats.set_sampler.sum * 1000;
+  for (size_t i = 0; i < METRICS_BINS && i < stats.get_sampler.bins.size(); i++) {
+    m.get_bins[i] = stats.get_sampler.bins[i];
+    m.set_bins[i] = stats.set_sampler.bins[i];
+  }
+
+  uint64_t *src = (uint64_t *) &m, *dst = (uint64_t *) &data;
+
+  __atomic_store_n(&seq, seq + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  for (size_t i = 0; i < WORDS; i++)
+    __atomic_store_n(&dst[i], src[i], __ATOMIC_RELAXED);
+  __atomic_store_n(&seq, seq + 1, __ATOMIC_RELEASE);
+}
+
+// Returns false if the snapshot changed while it was being copied.
+bool MetricsSlot::read(metrics_t& out) {
+  uint64_t *src = (uint64_t *) &data, *dst = (uint64_t *) &out;
+
+  uint64_t before = __atomic_load_n(&seq, __ATOMIC_ACQUIRE);
+  if (before & 1) return false;
+
+  for (size_t i = 0; i < WORDS; i++)
+    dst[i] = __atomic_load_n(&src[i], __ATOMIC_RELAXED);
+
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  return __atomic_load_n(&seq, __ATOMIC_RELAXED) == before;
+}
+
+static void print_histogram(struct evbuffer *out, const char *type,
+                            const uint64_t *bins, uint64_t sum_ns) {
+  uint64_t count = 0;
+
+  // Bin i of a LogSampler holds latencies below _POW^(i + 1) microseconds.
+  for (int i = 0; i < METRICS_BINS - 1; i++) {
+    count += bins[i];
+    evbuffer_add_printf(out, "slo_measure_latency_seconds_bucket"
+                        "{type=\"%s\",le=\"%g\"} %" PRIu64 "\n", type,
+                        pow(_POW, i + 1) / 1000000, count);
+  }
+  count += bins[METRICS_BINS - 1];
+
+  evbuffer_add_printf(out, "slo_measure_latency_seconds_bucket"
+                      "{type=\"%s\",le=\"+Inf\"} %" PRIu64 "\n", type, count);
+  evbuffer_add_printf(out, "slo_measure_latency_seconds_sum{type=\"%s\"} %g\n",
+                      type, sum_ns / 1e9);
+  evbuffer_add_printf(out, "slo_measure_latency_seconds_count{type=\"%s\"} "
+                      "%" PRIu64 "\n", type, count);
+}
+
+static void metrics_cb(struct evhttp_request *req, void *arg) {
+  const char *path = evhttp_uri_get_path(evhttp_request_get_evhttp_uri(req));
+  if (path == NULL || strcmp(path, "/metrics")) {
+    evhttp_send_error(req, HTTP_NOTFOUND, NULL);
+    return;
+  }
+
+  metrics_t total = metrics_t();
+  uint64_t *sum = (uint64_t *) &total;
+  uint64_t now_us = 0;
+
+  for (auto &slot: slots) {
+    metrics_t m;
+    while (!slot.read(m)) sched_yield();
+
+    // Threads that have not published yet.
+    if (m.time_us == 0) continue;
+
+    uint64_t *word = (uint64_t *) &m;
+    for (size_t i = 0; i < WORDS; i++) sum[i] += word[i];
+    total.start_us = m.start_us;
+    if (m.time_us > now_us) now_us = m.time_us;
+  }
+
+  // QPS since the previous scrape, or since the start for the first one.
+  // Scrapes closer together than the threads publish repeat the last one.
+  uint64_t ops = total.gets + total.sets + total.commands;
+  uint64_t from = last_us ? last_us : total.start_us;
+  if (now_us > from) {
+    last_qps = (ops - last_ops) / ((now_us - from) / 1e6);
+    last_ops = ops;
+    last_us = now_us;
+  }
+
+  struct evbuffer *out = evbuffer_new();
+
+  evbuffer_add_printf(out,
+    "# HELP slo_measure_qps Requests per second since the previous scrape.\n"
+    "# TYPE slo_measure_qps gauge\n"
+    "slo_measure_qps %.1f\n"
+    "# HELP slo_measure_requests_total Requests completed.\n"
+    "# TYPE slo_measure_requests_total counter\n"
+    "slo_measure_requests_total{type=\"get\"} %" PRIu64 "\n"
+    "slo_measure_requests_total{type=\"set\"} %" PRIu64 "\n"
+    "slo_measure_requests_total{type=\"other\"} %" PRIu64 "\n"
+    "# HELP slo_measure_get_keys_total Keys asked for by gets.\n"
+    "# TYPE slo_measure_get_keys_total counter\n"
+    "slo_measure_get_keys_total{result=\"hit\"} %" PRIu64 "\n"
+    "slo_measure_get_keys_total{result=\"miss\"} %" PRIu64 "\n"
+    "# HELP slo_measure_bytes_total Bytes received and sent.\n"
+    "# TYPE slo_measure_bytes_total counter\n"
+    "slo_measure_bytes_total{direction=\"rx\"} %" PRIu64 "\n"
+    "slo_measure_bytes_total{direction=\"tx\"} %" PRIu64 "\n"
+    "# HELP slo_measure_latency_seconds Request latency.\n"
+    "# TYPE slo_measure_latency_seconds histogram\n",
+    last_qps, total.gets, total.sets, total.commands,
+    total.get_keys - total.get_misses, total.get_misses,
+    total.rx_bytes, total.tx_bytes);
+  print_histogram(out, "get", total.get_bins, total.get_sum_ns);
+  print_histogram(out, "set", total.set_bins, total.set_sum_ns);
+
+  evhttp_add_header(evhttp_request_get_output_headers(req), "Content-Type",
+                    "text/plain; version=0.0.4");
+  evhttp_send_reply(req, HTTP_OK, "OK", out);
+  evbuffer_free(out);
+}
+
+static void stop_cb(evutil_socket_t fd, short what, void *ptr) {
+  if (__atomic_load_n(&stopping, __ATOMIC_ACQUIRE))
+    event_base_loopbreak(metrics_base);
+}
+
+static void* metrics_main(void *arg) {
+  // Scrapes must not take CPU time from the threads being measured.
+  struct sched_param param;
+  memset(&param, 0, sizeof(param));
+  pthread_setschedparam(pthread_self(), SCHED_IDLE, &param);
+
+  struct timeval tv = {0, 100000};
+  struct event *stop_timer;
+  DIE_Z(stop_timer = event_new(metrics_base, -1, EV_PERSIST, stop_cb, NULL));
+  evtimer_add(stop_timer, &tv);
+
+  event_base_dispatch(metrics_base);
+
+  event_free(stop_timer);
+  return NULL;
+}
+
+void metrics_start(int port, int threads) {
+  slots = vector<MetricsSlot>(threads);
+
+  DIE_Z(metrics_base = event_base_new());
+  DIE_Z(metrics_http = evhttp_new(metrics_base));
+  if (evhttp_bind_socket(metrics_http, "127.0.0.1", port)) {
+    char buf[100];
+    snprintf(buf, 100, "Cannot serve metrics on port %d", port);
+    die(buf);
+  }
+  evhttp_set_gencb(metrics_http, metrics_cb, NULL);
+
+  DIE_NZ(pthread_create(&metrics_thread, NULL, metrics_main, NULL));
+}
+
+void metrics_stop() {
+  if (metrics_base == NULL) return;
+
+  __atomic_store_n(&stopping, true, __ATOMIC_RELEASE);
+  DIE_NZ(pthread_join(metrics_thread, NULL));
+
+  evhttp_free(metrics_http);
+  event_base_free(metrics_base);
+  metrics_base = NULL;
+}
+
+MetricsSlot* metrics_slot(int id) {
+  return id < (int) slots.size() ? &slots[id] : NULL;
+}
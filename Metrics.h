@@ -0,0 +1,50 @@
+/* -*- c++ -*- */
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <inttypes.h>
+
+#include "ConnectionStats.h"
+
+#define METRICS_BINS 201
+
+// What a thread last published of its stats.  Only 64-bit words, so that
+// a snapshot can be copied word by word with atomic accesses.
+struct metrics_t {
+  uint64_t start_us, time_us;
+  uint64_t gets, sets, commands;
+  uint64_t get_keys, get_misses;
+  uint64_t rx_bytes, tx_bytes;
+  uint64_t get_sum_ns, set_sum_ns;
+  uint64_t get_bins[METRICS_BINS], set_bins[METRICS_BINS];
+};
+
+/**
+ * One thread's snapshot behind a seqlock: the thread overwrites it in
+ * place without ever waiting, and the metrics thread retries a read that
+ * overlapped a write.
+ */
+class MetricsSlot {
+public:
+  MetricsSlot() : seq(0), data() {}
+
+  void publish(ConnectionStats& stats, double now);
+  bool read(metrics_t& out);
+
+private:
+  uint64_t seq;
+  metrics_t data;
+};
+
+/**
+ * Serve the threads' latest snapshots in the Prometheus text format at
+ * http://127.0.0.1:port/metrics, from a thread of its own at idle
+ * priority.
+ */
+void metrics_start(int port, int threads);
+void metrics_stop();
+
+// Thread id's slot, or NULL without --metrics.
+MetricsSlot* metrics_slot(int id);
+
+#endif
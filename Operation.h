@@ -1,21 +1,81 @@
 #ifndef OPERATION_H
 #define OPERATION_H
 
+#include <inttypes.h>
+
 #include <string>
 
 using namespace std;
 
+class Connection;
+
 class Operation {
 public:
+  Operation() : keys(1), hits(0), lost(false), cas(0), conflict(false),
+    rmw(false), refill(false), miss_time(0.0), size_class(-1), version(0),
+    value(0), exptime(0), queue(0), origin(NULL), parent(NULL), pending(0), hedge_id(0),
+    backup(false) {}
+
   double start_time, end_time;
 
+  // The commands that can be part of --mix come first.
   enum type_enum {
-    GET, SET, SASL
+    GET, SET, DELETE, INCR, DECR, TOUCH, APPEND, PREPEND, GETS, CAS,
+    FENCE, SASL
   };
 
+  static const int COMMANDS = CAS + 1;
+
+  static const char* name(int type) {
+    static const char *names[] = {
+      "get", "set", "delete", "incr", "decr", "touch", "append", "prepend",
+      "gets", "cas", "fence", "sasl"
+    };
+    return names[type];
+  }
+
   type_enum type;
 
   string key;
+  int keys, hits;
+  bool lost;
+
+  // The cas token from a gets, whether a cas found the item changed, and
+  // whether the operation is a step of a gets/cas read-modify-write.
+  uint64_t cas;
+  bool conflict;
+  bool rmw;
+
+  // A set that refills the cache after a get missed, in cache-aside mode,
+  // and when the miss was answered.
+  bool refill;
+  double miss_time;
+
+  // The slab class of a single-key get or set's value, or -1.
+  int size_class;
+
+  // With --verify, the version a set or cas stores, or the oldest version
+  // a single-key get may see.
+  uint64_t version;
+
+  // Where a set, append, prepend or cas takes its value from random_char,
+  // and a set's exptime, both drawn by the issuing connection.
+  int value;
+  int exptime;
+
+  // Requests ahead of it on the connection that sent it.
+  int queue;
+
+  // The connection that issued the operation and logs its latency, and
+  // the logical operation it is a part of when a request spans servers.
+  Connection *origin;
+  Operation *parent;
+  int pending;
+
+  // Hedged gets: which get this is a copy of, and whether it is the
+  // backup copy sent after the hedge threshold.
+  uint64_t hedge_id;
+  bool backup;
 
   double time() const { return (end_time - start_time) * 1000000; }
 };
@@ -0,0 +1,196 @@
+#include <math.h>
+#include <string.h>
+
+#include "Output.h"
+#include "util.h"
+
+string Output::label(double percentile) {
+  char buf[32];
+  snprintf(buf, sizeof(buf), "p%g", percentile);
+  return buf;
+}
+
+void OutputJSON::begin() {
+  fprintf(out, "{");
+}
+
+void OutputJSON::section(const char* name) {
+  fprintf(out, "%s\n  \"%s\": {", sections++ ? "\n  }," : "", name);
+  first = true;
+}
+
+void OutputJSON::key(const char* name) {
+  fprintf(out, "%s\n    ", first ? "" : ",");
+  quoted(name);
+  fprintf(out, ": ");
+  first = false;
+}
+
+// JSON has no infinities or NaNs, e.g. the average of an empty sampler.
+void OutputJSON::number(double v) {
+  if (isfinite(v)) fprintf(out, "%.10g", v);
+  else fprintf(out, "null");
+}
+
+void OutputJSON::quoted(const string& s) {
+  fputc('"', out);
+  for (unsigned char c: s) {
+    if (c == '"' || c == '\\') fprintf(out, "\\%c", c);
+    else if (c < 0x20) fprintf(out, "\\u%04x", c);
+    else fputc(c, out);
+  }
+  fputc('"', out);
+}
+
+void OutputJSON::value(const char* name, double v) {
+  key(name);
+  number(v);
+}
+
+void OutputJSON::value(const char* name, const string& v) {
+  key(name);
+  quoted(v);
+}
+
+void OutputJSON::list(const char* name, const vector<string>& values) {
+  key(name);
+  fprintf(out, "[");
+  for (size_t i = 0; i < values.size(); i++) {
+    if (i) fprintf(out, ", ");
+    quoted(values[i]);
+  }
+  fprintf(out, "]");
+}
+
+void OutputJSON::sampler(const char* name, LogSampler& s,
+                         const vector<double>& percentiles) {
+  uint64_t count = s.total();
+
+  key(name);
+  fprintf(out, "{\"count\": %" PRIu64 ", \"avg\": ", count);
+  number(count ? s.average() : 0.0);
+  fprintf(out, ", \"std\": ");
+  number(count ? s.stddev() : 0.0);
+  fprintf(out, ", \"min\": ");
+  number(count ? s.minimum() : 0.0);
+
+  fprintf(out, ", \"percentiles\": {");
+  for (size_t i = 0; i < percentiles.size(); i++) {
+    fprintf(out, "%s\"%s\": ", i ? ", " : "", label(percentiles[i]).c_str());
+    number(count ? s.get_nth(percentiles[i]) : 0.0);
+  }
+
+  fprintf(out, "}, \"buckets\": [");
+  bool any = false;
+  for (size_t i = 0; i < s.bins.size(); i++) {
+    if (s.bins[i] == 0) continue;
+    fprintf(out, "%s[", any ? ", " : "");
+    number(upper(s, i));
+    fprintf(out, ", %" PRIu64 "]", s.bins[i]);
+    any = true;
+  }
+  fprintf(out, "]}");
+}
+
+// A row is an object of its values, under its key.
+void OutputJSON::row(const string& key, const vector<string>& names,
+                     const vector<double>& values) {
+  this->key(key.c_str());
+  fprintf(out, "{");
+  for (size_t i = 0; i < names.size(); i++) {
+    fprintf(out, "%s", i ? ", " : "");
+    quoted(names[i]);
+    fprintf(out, ": ");
+    number(values[i]);
+  }
+  fprintf(out, "}");
+}
+
+void OutputJSON::end() {
+  fprintf(out, "%s\n}\n", sections ? "\n  }" : "");
+}
+
+void OutputCSV::begin() {
+  fprintf(out, "record,type,field,value\n");
+}
+
+static string csv_field(const string& s) {
+  if (s.find_first_of(",\"\r\n") == string::npos) return s;
+
+  string quoted = "\"";
+  for (char c: s) {
+    if (c == '"') quoted += '"';
+    quoted += c;
+  }
+  return quoted + "\"";
+}
+
+void OutputCSV::line(const string& type, const string& field,
+                     const string& value) {
+  fprintf(out, "%s,%s,%s,%s\n", record.c_str(), csv_field(type).c_str(),
+          csv_field(field).c_str(), csv_field(value).c_str());
+}
+
+void OutputCSV::line(const string& type, const string& field,
+                     double value) {
+  char buf[32];
+  if (isinf(value)) snprintf(buf, sizeof(buf), "inf");
+  else snprintf(buf, sizeof(buf), "%.10g", value);
+  line(type, field, string(buf));
+}
+
+void OutputCSV::line(const string& type, const string& field,
+                     uint64_t value) {
+  char buf[32];
+  snprintf(buf, sizeof(buf), "%" PRIu64, value);
+  line(type, field, string(buf));
+}
+
+void OutputCSV::value(const char* name, double v) {
+  line("", name, v);
+}
+
+void OutputCSV::value(const char* name, const string& v) {
+  line("", name, v);
+}
+
+void OutputCSV::list(const char* name, const vector<string>& values) {
+  for (auto &v: values) line("", name, v);
+}
+
+void OutputCSV::sampler(const char* name, LogSampler& s,
+                        const vector<double>& percentiles) {
+  uint64_t count = s.total();
+
+  line(name, "count", count);
+  line(name, "avg", count ? s.average() : 0.0);
+  line(name, "std", count ? s.stddev() : 0.0);
+  line(name, "min", count ? s.minimum() : 0.0);
+  for (auto p: percentiles)
+    line(name, label(p), count ? s.get_nth(p) : 0.0);
+
+  // Buckets as "bucket" records, keyed by their upper bound.
+  string saved = record;
+  record = "bucket";
+  for (size_t i = 0; i < s.bins.size(); i++) {
+    if (s.bins[i] == 0) continue;
+    char le[32];
+    snprintf(le, sizeof(le), "%.10g", upper(s, i));
+    line(name, le, s.bins[i]);
+  }
+  record = saved;
+}
+
+void OutputCSV::row(const string& key, const vector<string>& names,
+                    const vector<double>& values) {
+  for (size_t i = 0; i < names.size(); i++) line(key, names[i], values[i]);
+}
+
+Output* createOutput(const char* format, FILE* out) {
+  if (!strcmp(format, "text")) return NULL;
+  if (!strcmp(format, "json")) return new OutputJSON(out);
+  if (!strcmp(format, "csv")) return new OutputCSV(out);
+
+  die("--output must be text, json or csv");
+  return NULL;
+}
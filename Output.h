@@ -0,0 +1,101 @@
+/* -*- c++ -*- */
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+
+#include "LogSampler.h"
+
+using namespace std;
+
+/**
+ * Results in a machine-readable format, for --output.  A report is a
+ * sequence of sections (config, summary, latency, ...) holding named values;
+ * latency sections hold samplers, written with their percentiles and every
+ * non-empty bucket as its upper bound in microseconds and its count, and
+ * table sections hold rows, e.g. one per --report interval.  The last bucket
+ * has no bound of its own and is written with the largest sample instead.
+ */
+class Output {
+public:
+  Output(FILE* _out) : out(_out) {}
+  virtual ~Output() {}
+
+  virtual void begin() = 0;
+  virtual void section(const char* name) = 0;
+  virtual void value(const char* name, double v) = 0;
+  virtual void value(const char* name, const string& v) = 0;
+  virtual void list(const char* name, const vector<string>& values) = 0;
+  virtual void sampler(const char* name, LogSampler& s,
+                       const vector<double>& percentiles) = 0;
+  virtual void row(const string& key, const vector<string>& names,
+                   const vector<double>& values) = 0;
+  virtual void end() = 0;
+
+protected:
+  FILE *out;
+
+  // Upper bound of bucket i, the largest sample for the open last one.
+  static double upper(LogSampler& s, size_t i) {
+    return i + 1 < s.bins.size() ? pow(_POW, (double) i + 1) : s.max;
+  }
+
+  static string label(double percentile);
+};
+
+class OutputJSON : public Output {
+public:
+  OutputJSON(FILE* out) : Output(out), sections(0), first(true) {}
+
+  virtual void begin();
+  virtual void section(const char* name);
+  virtual void value(const char* name, double v);
+  virtual void value(const char* name, const string& v);
+  virtual void list(const char* name, const vector<string>& values);
+  virtual void sampler(const char* name, LogSampler& s,
+                       const vector<double>& percentiles);
+  virtual void row(const string& key, const vector<string>& names,
+                   const vector<double>& values);
+  virtual void end();
+
+private:
+  int sections;
+  bool first;
+
+  void key(const char* name);
+  void number(double v);
+  void quoted(const string& s);
+};
+
+// One "record,type,field,value" line per value, percentile, bucket and
+// table cell.
+class OutputCSV : public Output {
+public:
+  OutputCSV(FILE* out) : Output(out) {}
+
+  virtual void begin();
+  virtual void section(const char* name) { record = name; }
+  virtual void value(const char* name, double v);
+  virtual void value(const char* name, const string& v);
+  virtual void list(const char* name, const vector<string>& values);
+  virtual void sampler(const char* name, LogSampler& s,
+                       const vector<double>& percentiles);
+  virtual void row(const string& key, const vector<string>& names,
+                   const vector<double>& values);
+  virtual void end() {}
+
+private:
+  string record;
+
+  void line(const string& type, const string& field, const string& value);
+  void line(const string& type, const string& field, double value);
+  void line(const string& type, const string& field, uint64_t value);
+};
+
+// NULL for the plain text report.
+Output* createOutput(const char* format, FILE* out);
+
+#endif
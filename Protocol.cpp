@@ -7,66 +7,35 @@
 #include "Protocol.h"
 #include "util.h"
 
-int ProtocolMemcachedText::get_request(const char* key) {
-  int l;
-  l = evbuffer_add_printf(bufferevent_get_output(bev), "get %s\r\n", key);
-  if (read_state == IDLE) read_state = WAITING_FOR_GET;
-  return l;
-}
-
-int ProtocolMemcachedText::set_request(const char* key, const char* value, int len) {
-  int l;
-  l = evbuffer_add_printf(bufferevent_get_output(bev),
-                          "set %s 0 0 %d\r\n", key, len);
-  bufferevent_write(bev, value, len);
-  bufferevent_write(bev, "\r\n", 2);
-  l += len + 2;
-  if (read_state == IDLE) read_state = WAITING_FOR_END;
-  return l;
+Protocol::Protocol(Connection* _conn, bufferevent* _bev) :
+  conn(_conn), bev(_bev), options(_conn->options), stats(_conn->stats) {}
+
+/**
+ * With --sasl, authenticate with the text protocol's authentication
+ * command: a set whose value is "username password".
+ */
+bool ProtocolMemcachedText::setup_connection_w() {
+  if (!options.sasl) return true;
+
+  string auth = string(options.username) + " " + options.password;
+  evbuffer_add_printf(bufferevent_get_output(bev), "set auth 0 0 %d\r\n%s\r\n",
+                      (int) auth.length(), auth.c_str());
+  return false;
 }
 
-bool ProtocolMemcachedText::handle_response(evbuffer *input, bool &done) {
-  char *buf = NULL;
-  int len;
+bool ProtocolMemcachedText::setup_connection_r(evbuffer* input) {
+  char *buf;
   size_t n_read_out;
 
-  switch (read_state) {
-  case WAITING_FOR_GET:
-  case WAITING_FOR_END:
-    buf = evbuffer_readln(input, &n_read_out, EVBUFFER_EOL_CRLF);
-    if (buf == NULL) return false;
-
-    conn->stats.rx_bytes += n_read_out;
+  buf = evbuffer_readln(input, &n_read_out, EVBUFFER_EOL_CRLF);
+  if (buf == NULL) return false;
 
-    if (!strncmp(buf, "END", 3)) {
-      if (read_state == WAITING_FOR_GET) conn->stats.get_misses++;
-      read_state = WAITING_FOR_GET;
-      done = true;
-    } else if (!strncmp(buf, "VALUE", 5)) {
-      sscanf(buf, "VALUE %*s %*d %d", &len);
-      data_length = len;
-      read_state = WAITING_FOR_GET_DATA;
-      done = false;
-    } else {
-      done = false;
-    }
-    free(buf);
-    return true;
-
-  case WAITING_FOR_GET_DATA:
-    len = evbuffer_get_length(input);
-    if (len >= data_length + 2) {
-      evbuffer_drain(input, data_length + 2);
-      read_state = WAITING_FOR_END;
-      conn->stats.rx_bytes += data_length + 2;
-      done = false;
-      return true;
-    }
-    return false;
-
-  default: printf("state: %d\n", read_state); die("Unimplemented!");
+  if (strncmp(buf, "STORED", 6)) {
+    char err[100];
+    snprintf(err, 100, "SASL authentication failed: %s", buf);
+    die(err);
   }
 
-  die("Shouldn't ever reach here...");
-  return false;
-}
\ No newline at end of file
+  free(buf);
+  return true;
+}
@@ -1,30 +1,65 @@
 #ifndef PROTOCOL_H
 #define PROTOCOL_H
 
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+
 #include <event2/bufferevent.h>
+#include <event2/buffer.h>
 
+#include "config.h"
 #include "ConnectionOptions.h"
+#include "ConnectionStats.h"
+#include "Operation.h"
+#include "Verify.h"
+#include "util.h"
+
+using namespace std;
 
 class Connection;
 
+/**
+ * A protocol writes requests to its connection's bufferevent and parses
+ * the answers.  The request and answer paths are defined inline below, so
+ * that they are compiled into the engine of ConnectionT.
+ */
 class Protocol {
 public:
-  Protocol(Connection* _conn, bufferevent* _bev):
-    conn(_conn), bev(_bev) {};
-  ~Protocol() {};
+  Protocol(Connection* _conn, bufferevent* _bev);
+  virtual ~Protocol() {};
 
   virtual bool setup_connection_w() = 0;
   virtual bool setup_connection_r(evbuffer* input) = 0;
   virtual int get_request(const char* key) = 0;
-  virtual int set_request(const char* key, const char* value, int len) = 0;
-  virtual bool handle_response(evbuffer* input, bool &done) = 0;
+  virtual int set_request(const char* key, const char* value, int len,
+                          int exptime, bool noreply,
+                          const string& header) = 0;
+  virtual int fence_request() = 0;
+  virtual int gets_request(const char* key) = 0;
+  virtual int delete_request(const char* key) = 0;
+  virtual int arith_request(const char* key, bool decr, uint64_t delta) = 0;
+  virtual int touch_request(const char* key, int exptime) = 0;
+  virtual int concat_request(const char* key, const char* value, int len,
+                             bool prepend) = 0;
+  virtual int cas_request(const char* key, const char* value, int len,
+                          uint64_t cas, const string& header) = 0;
+  virtual bool handle_response(evbuffer* input, Operation* op, bool &done) = 0;
 
 protected:
   Connection *conn;
   bufferevent *bev;
+  const options_t& options;
+  ConnectionStats& stats;
+
+  void write_value(const char* value, int len,
+                   const string& header = string());
 };
 
-class ProtocolMemcachedText : public Protocol {
+class ProtocolMemcachedText final : public Protocol {
 public:
   ProtocolMemcachedText(Connection* conn, bufferevent* bev):
     Protocol(conn, bev) {
@@ -33,11 +68,23 @@ public:
 
   ~ProtocolMemcachedText() {};
 
-  virtual bool setup_connection_w() { return true; }
-  virtual bool setup_connection_r(evbuffer* input) { return true; }
+  virtual bool setup_connection_w();
+  virtual bool setup_connection_r(evbuffer* input);
   virtual int  get_request(const char* key);
-  virtual int  set_request(const char* key, const char* value, int len);
-  virtual bool handle_response(evbuffer* input, bool &done);
+  virtual int  set_request(const char* key, const char* value, int len,
+                           int exptime, bool noreply, const string& header);
+  virtual int  fence_request();
+  virtual int  gets_request(const char* key);
+  virtual int  delete_request(const char* key);
+  virtual int  arith_request(const char* key, bool decr, uint64_t delta);
+  virtual int  touch_request(const char* key, int exptime);
+  virtual int  concat_request(const char* key, const char* value, int len,
+                              bool prepend);
+  virtual int  cas_request(const char* key, const char* value, int len,
+                           uint64_t cas, const string& header);
+  // Too large for the inliner's taste, but the engine calls it once.
+  virtual bool handle_response(evbuffer* input, Operation* op, bool &done)
+    __attribute__((always_inline));
 
 private:
   enum read_fsm {
@@ -48,7 +95,226 @@ private:
   };
 
   read_fsm read_state;
+
+  // Bytes of the current value, and of its trailing CRLF, not read yet.
   int data_length;
+  Verifier verifier;
+
+  int verify_data(evbuffer* input, int len);
 };
 
-#endif
\ No newline at end of file
+/**
+ * Queue a value and its CRLF.  A header, if any, takes the place of the
+ * value's first bytes.  Values of VALUE_REFERENCE bytes or more start in
+ * random_char, which never changes: they are queued by reference instead
+ * of copied, wrapping around its end, so values of any size cost neither a
+ * copy nor memory.
+ */
+inline void Protocol::write_value(const char* value, int len,
+                                  const string& header) {
+  evbuffer *output = bufferevent_get_output(bev);
+
+  evbuffer_add(output, header.data(), header.size());
+  len -= header.size();
+
+  if (len < VALUE_REFERENCE) {
+    evbuffer_add(output, value, len);
+  } else {
+    size_t offset = value - random_char;
+    while (len > 0) {
+      int n = min((size_t) len, RANDOM_CHAR_SIZE - offset);
+      evbuffer_add_reference(output, random_char + offset, n, NULL, NULL);
+      len -= n;
+      offset = 0;
+    }
+  }
+
+  evbuffer_add(output, "\r\n", 2);
+}
+
+inline int ProtocolMemcachedText::get_request(const char* key) {
+  int l;
+  l = evbuffer_add_printf(bufferevent_get_output(bev), "get %s\r\n", key);
+  if (read_state == IDLE) read_state = WAITING_FOR_GET;
+  return l;
+}
+
+inline int ProtocolMemcachedText::set_request(const char* key,
+                                              const char* value, int len,
+                                              int exptime, bool noreply,
+                                              const string& header) {
+  int l;
+  l = evbuffer_add_printf(bufferevent_get_output(bev),
+                          "set %s 0 %d %d%s\r\n", key, exptime, len,
+                          noreply ? " noreply" : "");
+  write_value(value, len, header);
+  l += len + 2;
+  if (read_state == IDLE) read_state = WAITING_FOR_END;
+  return l;
+}
+
+// The meta no-op answers with a single line once everything sent before it
+// has been processed, which makes it a cheap fence behind noreply commands.
+inline int ProtocolMemcachedText::fence_request() {
+  int l;
+  l = evbuffer_add_printf(bufferevent_get_output(bev), "mn\r\n");
+  if (read_state == IDLE) read_state = WAITING_FOR_END;
+  return l;
+}
+
+inline int ProtocolMemcachedText::gets_request(const char* key) {
+  int l;
+  l = evbuffer_add_printf(bufferevent_get_output(bev), "gets %s\r\n", key);
+  if (read_state == IDLE) read_state = WAITING_FOR_GET;
+  return l;
+}
+
+inline int ProtocolMemcachedText::delete_request(const char* key) {
+  int l;
+  l = evbuffer_add_printf(bufferevent_get_output(bev), "delete %s\r\n", key);
+  if (read_state == IDLE) read_state = WAITING_FOR_END;
+  return l;
+}
+
+inline int ProtocolMemcachedText::arith_request(const char* key, bool decr,
+                                                uint64_t delta) {
+  int l;
+  l = evbuffer_add_printf(bufferevent_get_output(bev), "%s %s %" PRIu64 "\r\n",
+                          decr ? "decr" : "incr", key, delta);
+  if (read_state == IDLE) read_state = WAITING_FOR_END;
+  return l;
+}
+
+inline int ProtocolMemcachedText::touch_request(const char* key, int exptime) {
+  int l;
+  l = evbuffer_add_printf(bufferevent_get_output(bev), "touch %s %d\r\n",
+                          key, exptime);
+  if (read_state == IDLE) read_state = WAITING_FOR_END;
+  return l;
+}
+
+inline int ProtocolMemcachedText::concat_request(const char* key,
+                                                 const char* value, int len,
+                                                 bool prepend) {
+  int l;
+  l = evbuffer_add_printf(bufferevent_get_output(bev), "%s %s 0 0 %d\r\n",
+                          prepend ? "prepend" : "append", key, len);
+  write_value(value, len);
+  l += len + 2;
+  if (read_state == IDLE) read_state = WAITING_FOR_END;
+  return l;
+}
+
+inline int ProtocolMemcachedText::cas_request(const char* key,
+                                              const char* value, int len,
+                                              uint64_t cas,
+                                              const string& header) {
+  int l;
+  l = evbuffer_add_printf(bufferevent_get_output(bev),
+                          "cas %s 0 0 %d %" PRIu64 "\r\n", key, len, cas);
+  write_value(value, len, header);
+  l += len + 2;
+  if (read_state == IDLE) read_state = WAITING_FOR_END;
+  return l;
+}
+
+/**
+ * Feed the verifier the first len bytes of input without copying them.
+ * Returns how many of them it saw, which may be fewer when they are spread
+ * over many chunks.
+ */
+inline int ProtocolMemcachedText::verify_data(evbuffer* input, int len) {
+  evbuffer_iovec v[8];
+  int n = min(evbuffer_peek(input, len, NULL, v, 8), 8);
+  int seen = 0;
+
+  for (int i = 0; i < n && seen < len; i++) {
+    int m = min((int) v[i].iov_len, len - seen);
+    // The trailing CRLF is not part of the value.
+    int value = min(m, data_length - 2 - seen);
+    if (value > 0) verifier.update((const char *) v[i].iov_base, value);
+    seen += m;
+  }
+
+  return seen;
+}
+
+inline bool ProtocolMemcachedText::handle_response(evbuffer *input,
+                                                   Operation *op,
+                                                   bool &done) {
+  char *buf = NULL;
+  int len;
+  size_t n_read_out;
+
+  switch (read_state) {
+  case WAITING_FOR_GET:
+  case WAITING_FOR_END:
+    buf = evbuffer_readln(input, &n_read_out, EVBUFFER_EOL_CRLF);
+    if (buf == NULL) return false;
+
+    stats.rx_bytes += n_read_out;
+
+    if (!strncmp(buf, "END", 3)) {
+      read_state = WAITING_FOR_GET;
+      done = true;
+    } else if (!strncmp(buf, "VALUE", 5)) {
+      char key[256];
+      sscanf(buf, "VALUE %255s %*d %d %" SCNu64, key, &len, &op->cas);
+      data_length = len + 2;
+      stats.value_rx += len;
+      op->hits++;
+      // Only a single-key get knows which version it must see at least.
+      if (options.verify)
+        verifier.begin(key, len, op->keys == 1 ? op->version : 0);
+      read_state = WAITING_FOR_GET_DATA;
+      done = false;
+    } else {
+      // Servers before memcached 1.6 have no mn, and the loader and
+      // --noreply would wait for their sets forever.
+      if (op->type == Operation::FENCE && !strncmp(buf, "ERROR", 5))
+        die("The server does not know the mn fence behind loading and "
+            "--noreply sets: they need memcached 1.6 or later");
+
+      // A one-line answer: anything but a miss or a cas conflict succeeded.
+      if (!strncmp(buf, "EXISTS", 6)) op->conflict = true;
+      else if (strncmp(buf, "NOT_", 4) && strncmp(buf, "MN", 2) &&
+               strstr(buf, "ERROR") == NULL)
+        op->hits = 1;
+      done = false;
+    }
+    free(buf);
+    return true;
+
+  case WAITING_FOR_GET_DATA:
+    // Values are dropped as they arrive rather than buffered whole, and
+    // checked on the way with --verify.
+    while (data_length > 0 && evbuffer_get_length(input) > 0) {
+      len = min(evbuffer_get_length(input), (size_t) data_length);
+      if (options.verify) len = verify_data(input, len);
+      evbuffer_drain(input, len);
+      stats.rx_bytes += len;
+      data_length -= len;
+    }
+    if (data_length > 0) return false;
+
+    if (options.verify) {
+      stats.verified++;
+      switch (verifier.finish()) {
+      case Verifier::CORRUPT: stats.corrupt++; break;
+      case Verifier::STALE: stats.stale++; break;
+      default: break;
+      }
+    }
+
+    read_state = WAITING_FOR_END;
+    done = false;
+    return true;
+
+  default: printf("state: %d\n", read_state); die("Unimplemented!");
+  }
+
+  die("Shouldn't ever reach here...");
+  return false;
+}
+
+#endif
@@ -0,0 +1,57 @@
+/* -*- c++ -*- */
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <inttypes.h>
+
+/**
+ * xoshiro256** by Blackman and Vigna.  Each connection owns one, so that
+ * threads share no state and a --seed reproduces every connection's
+ * request stream.
+ */
+class Random {
+public:
+  Random(uint64_t seed = 0, uint64_t stream = 0) { reseed(seed, stream); }
+
+  // Independent streams of the same seed start from different states.
+  void reseed(uint64_t seed, uint64_t stream) {
+    uint64_t x = seed ^ (stream * 0xd1342543de82ef95ULL);
+    for (int i = 0; i < 4; i++) s[i] = splitmix64(x);
+  }
+
+  uint64_t next() {
+    uint64_t result = rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+
+    return result;
+  }
+
+  // Uniform in [0, n), by Lemire's multiply-shift.
+  uint64_t below(uint64_t n) {
+    return (uint64_t) (((unsigned __int128) next() * n) >> 64);
+  }
+
+  // Uniform in [0, 1).
+  double uniform() { return (next() >> 11) / 9007199254740992.0; }
+
+private:
+  uint64_t s[4];
+
+  static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+  static uint64_t splitmix64(uint64_t& x) {
+    uint64_t z = (x += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+  }
+};
+
+#endif
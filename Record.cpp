@@ -0,0 +1,83 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <time.h>
+
+#include <vector>
+
+#include "Record.h"
+#include "util.h"
+
+using namespace std;
+
+static vector<RecordRing*> rings;
+static pthread_t record_thread;
+static FILE *record_file = NULL;
+static bool stopping = false;
+
+size_t RecordRing::drain(FILE* f) {
+  uint64_t end = __atomic_load_n(&head, __ATOMIC_ACQUIRE);
+  size_t n = end - tail;
+
+  // At most two pieces, when the records wrap around the end of the ring.
+  while (tail < end) {
+    size_t at = tail & (RECORD_RING - 1);
+    size_t chunk = min((uint64_t) (RECORD_RING - at), end - tail);
+    if (fwrite(&records[at], sizeof(record_t), chunk, f) != chunk)
+      die("Cannot write --record file");
+    __atomic_store_n(&tail, tail + chunk, __ATOMIC_RELEASE);
+  }
+
+  return n;
+}
+
+static void* record_main(void *arg) {
+  struct timespec ts = {0, (long) (RECORD_DRAIN * 1e9)};
+
+  while (1) {
+    // Records pushed before the threads finished are seen by the last
+    // pass.
+    bool last = __atomic_load_n(&stopping, __ATOMIC_ACQUIRE);
+
+    size_t n = 0;
+    for (auto ring: rings) n += ring->drain(record_file);
+
+    if (last) break;
+    if (n == 0) nanosleep(&ts, NULL);
+  }
+
+  return NULL;
+}
+
+void record_start(const char* path, int threads) {
+  if ((record_file = fopen(path, "w")) == NULL) {
+    char buf[300];
+    snprintf(buf, sizeof(buf), "Cannot open --record file %s", path);
+    die(buf);
+  }
+  setvbuf(record_file, NULL, _IOFBF, 1024 * 1024);
+
+  record_file_t header = {RECORD_MAGIC, sizeof(record_t)};
+  if (fwrite(&header, sizeof(header), 1, record_file) != 1)
+    die("Cannot write --record file");
+
+  for (int t = 0; t < threads; t++) rings.push_back(new RecordRing());
+
+  DIE_NZ(pthread_create(&record_thread, NULL, record_main, NULL));
+}
+
+void record_stop() {
+  if (record_file == NULL) return;
+
+  __atomic_store_n(&stopping, true, __ATOMIC_RELEASE);
+  DIE_NZ(pthread_join(record_thread, NULL));
+
+  if (fclose(record_file)) die("Cannot write --record file");
+  record_file = NULL;
+
+  for (auto ring: rings) delete ring;
+  rings.clear();
+}
+
+RecordRing* record_ring(int id) {
+  return id < (int) rings.size() ? rings[id] : NULL;
+}
@@ -0,0 +1,73 @@
+/* -*- c++ -*- */
+#ifndef RECORD_H
+#define RECORD_H
+
+#include <inttypes.h>
+#include <stdio.h>
+
+#include "config.h"
+
+#define RECORD_MAGIC 0x31636572
+
+/**
+ * The --record file is a record_file_t followed by one record_t per
+ * request, in the byte order of the host, threads' records interleaved in
+ * batches.
+ */
+struct record_file_t {
+  uint32_t magic;
+  uint32_t size;  // sizeof(record_t)
+};
+
+struct record_t {
+  uint64_t start_ns;    // Since the Unix epoch.
+  uint64_t latency_ns;
+  uint32_t key;         // Key index; the first key of a multiget.
+  uint32_t size;        // Value length of the key.
+  uint32_t connection;  // server * MAXIMUM_CONNECTIONS + connection
+  uint16_t queue;       // Requests ahead of it on its connection.
+  uint8_t type;         // Operation::type_enum
+  uint8_t hits;
+};
+
+/**
+ * A thread's records on their way to the writer thread.  Single producer,
+ * single consumer: the thread never waits for the writer, and drops what
+ * does not fit.
+ */
+class RecordRing {
+public:
+  RecordRing() : head(0), tail(0), records(new record_t[RECORD_RING]) {}
+  ~RecordRing() { delete[] records; }
+
+  bool push(const record_t& r) {
+    if (head - __atomic_load_n(&tail, __ATOMIC_ACQUIRE) == RECORD_RING)
+      return false;
+    records[head & (RECORD_RING - 1)] = r;
+    __atomic_store_n(&head, head + 1, __ATOMIC_RELEASE);
+    return true;
+  }
+
+  // Writer thread only.  Returns the number of records written.
+  size_t drain(FILE* f);
+
+private:
+  // Head and tail on separate cache lines, so that the thread and the
+  // writer do not bounce one line between them.
+  uint64_t head;
+  char pad[56];
+  uint64_t tail;
+  record_t *records;
+};
+
+/**
+ * Start the thread that writes the threads' rings to path, and stop it
+ * once the threads are done, after it has written everything left.
+ */
+void record_start(const char* path, int threads);
+void record_stop();
+
+// Thread id's ring, or NULL without --record.
+RecordRing* record_ring(int id);
+
+#endif
@@ -0,0 +1,74 @@
+#include <pthread.h>
+
+#include <map>
+
+#include "TLS.h"
+#include "util.h"
+
+static SSL_CTX *ctx = NULL;
+static bool resume = false;
+
+// Server name of each SSL, and the latest session of each server.  The
+// sessions are shared by all threads.
+static int server_index = -1;
+static map<string, SSL_SESSION*> sessions;
+static pthread_mutex_t sessions_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void free_server(void *parent, void *ptr, CRYPTO_EX_DATA *ad,
+                        int idx, long argl, void *argp) {
+  delete (string *) ptr;
+}
+
+static int new_session(SSL *ssl, SSL_SESSION *session) {
+  string *server = (string *) SSL_get_ex_data(ssl, server_index);
+  if (server == NULL) return 0;
+
+  pthread_mutex_lock(&sessions_lock);
+  SSL_SESSION *&cached = sessions[*server];
+  if (cached) SSL_SESSION_free(cached);
+  cached = session;
+  pthread_mutex_unlock(&sessions_lock);
+
+  return 1;
+}
+
+void tls_init(bool _resume) {
+  resume = _resume;
+
+  DIE_Z(ctx = SSL_CTX_new(TLS_client_method()));
+  SSL_CTX_set_verify(ctx, SSL_VERIFY_NONE, NULL);
+
+  server_index = SSL_get_ex_new_index(0, NULL, NULL, NULL, free_server);
+
+  if (resume) {
+    SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_CLIENT |
+                                   SSL_SESS_CACHE_NO_INTERNAL_STORE);
+    SSL_CTX_sess_set_new_cb(ctx, new_session);
+  } else {
+    SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_OFF);
+    SSL_CTX_set_options(ctx, SSL_OP_NO_TICKET);
+  }
+}
+
+void tls_cleanup() {
+  for (auto &s: sessions) SSL_SESSION_free(s.second);
+  sessions.clear();
+  SSL_CTX_free(ctx);
+  ctx = NULL;
+}
+
+SSL* tls_new(const string& server) {
+  SSL *ssl;
+
+  DIE_Z(ssl = SSL_new(ctx));
+  SSL_set_ex_data(ssl, server_index, new string(server));
+
+  if (resume) {
+    pthread_mutex_lock(&sessions_lock);
+    auto it = sessions.find(server);
+    if (it != sessions.end()) SSL_set_session(ssl, it->second);
+    pthread_mutex_unlock(&sessions_lock);
+  }
+
+  return ssl;
+}
@@ -0,0 +1,19 @@
+/* -*- c++ -*- */
+#ifndef TLS_H
+#define TLS_H
+
+#include <string>
+
+#include <openssl/ssl.h>
+
+using namespace std;
+
+// Create the client context shared by every connection.  With resume,
+// each server's latest session is cached and offered on new connections.
+void tls_init(bool resume);
+void tls_cleanup();
+
+// A new client SSL for server, offering its cached session if there is one.
+SSL* tls_new(const string& server);
+
+#endif
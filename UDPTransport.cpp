@@ -0,0 +1,249 @@
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "Connection.h"
+#include "UDPTransport.h"
+#include "config.h"
+#include "util.h"
+
+UDPTransport::UDPTransport(Connection* _conn, struct event_base* base,
+                           const string& hostname, int port) :
+  conn(_conn), first_id(0), pending(0)
+{
+  struct sockaddr_in addr;
+
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  if (inet_pton(AF_INET, hostname.c_str(), &addr.sin_addr) != 1)
+    die("UDP needs a numeric IPv4 server address");
+
+  DIE_NE(fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0));
+  DIE_NZ(connect(fd, (struct sockaddr *) &addr, sizeof(addr)));
+
+  DIE_Z(read_event = event_new(base, fd, EV_READ | EV_PERSIST, udp_read_cb, this));
+  DIE_Z(flush_event = event_new(base, -1, 0, udp_flush_cb, this));
+  DIE_Z(timeout_timer = evtimer_new(base, udp_timeout_cb, this));
+  event_add(read_event, NULL);
+}
+
+UDPTransport::~UDPTransport() {
+  event_free(read_event);
+  event_free(flush_event);
+  event_free(timeout_timer);
+  close(fd);
+}
+
+static void put16(char* p, uint16_t v) {
+  v = htons(v);
+  memcpy(p, &v, 2);
+}
+
+static uint16_t get16(const char* p) {
+  uint16_t v;
+  memcpy(&v, p, 2);
+  return ntohs(v);
+}
+
+void UDPTransport::send_get(Operation& op) {
+  if (requests.size() >= 65536) die("Too many UDP requests outstanding.");
+
+  uint16_t id = first_id + requests.size();
+  requests.push_back({op, vector<string>(), vector<bool>(), 0, 0, -1, false,
+                      false});
+  pending++;
+
+  char header[8];
+  put16(header, id);
+  put16(header + 2, 0);
+  put16(header + 4, 1);
+  put16(header + 6, 0);
+
+  string d = string(header, 8) + "get " + op.key + "\r\n";
+  if (d.length() > UDP_DATAGRAM) die("A get does not fit in one UDP datagram.");
+
+  conn->stats.tx_bytes += d.length();
+  conn->stats.udp_gets++;
+
+  // Everything queued during this pass of the event loop is sent together.
+  outgoing.push_back(d);
+  if (outgoing.size() == 1) event_active(flush_event, EV_TIMEOUT, 0);
+
+  if (!evtimer_pending(timeout_timer, NULL)) schedule_timeout();
+}
+
+void UDPTransport::flush() {
+  struct mmsghdr msgs[UDP_BATCH];
+  struct iovec iovs[UDP_BATCH];
+  size_t sent = 0;
+
+  while (sent < outgoing.size()) {
+    int n = min((size_t) UDP_BATCH, outgoing.size() - sent);
+
+    memset(msgs, 0, sizeof(msgs[0]) * n);
+    for (int i = 0; i < n; i++) {
+      iovs[i].iov_base = (void *) outgoing[sent + i].data();
+      iovs[i].iov_len = outgoing[sent + i].length();
+      msgs[i].msg_hdr.msg_iov = &iovs[i];
+      msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    int r = sendmmsg(fd, msgs, n, 0);
+    if (r < 0) {
+      // Datagrams the kernel has no room for are lost like any other.
+      if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS) break;
+      char buf[100];
+      snprintf(buf, 100, "UDP send failed: %s", strerror(errno));
+      die(buf);
+    }
+
+    sent += r;
+  }
+
+  outgoing.clear();
+}
+
+void UDPTransport::read_callback() {
+  static thread_local char buffers[UDP_BATCH][UDP_BUFFER];
+  struct mmsghdr msgs[UDP_BATCH];
+  struct iovec iovs[UDP_BATCH];
+
+  while (1) {
+    memset(msgs, 0, sizeof(msgs));
+    for (int i = 0; i < UDP_BATCH; i++) {
+      iovs[i].iov_base = buffers[i];
+      iovs[i].iov_len = UDP_BUFFER;
+      msgs[i].msg_hdr.msg_iov = &iovs[i];
+      msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    int r = recvmmsg(fd, msgs, UDP_BATCH, MSG_DONTWAIT, NULL);
+    if (r < 0) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK) return;
+      char buf[100];
+      snprintf(buf, 100, "UDP receive failed: %s", strerror(errno));
+      die(buf);
+    }
+
+    for (int i = 0; i < r; i++) receive(buffers[i], msgs[i].msg_len);
+    if (r < UDP_BATCH) return;
+  }
+}
+
+// Add one datagram to the answer it belongs to.
+void UDPTransport::receive(const char* buf, int len) {
+  if (len < 8) return;
+
+  uint16_t id = get16(buf);
+  int seq = get16(buf + 2);
+  int total = get16(buf + 4);
+  uint16_t index = id - first_id;
+
+  conn->stats.rx_bytes += len;
+
+  if (index >= requests.size() || requests[index].done) {
+    conn->stats.udp_late++;
+    return;
+  }
+
+  request_t &r = requests[index];
+  if (r.total == 0) {
+    r.total = total;
+    r.parts.resize(total);
+    r.filled.resize(total, false);
+  }
+  if (seq >= r.total || r.filled[seq]) return;
+
+  // An answer is reordered if it overtook the answer to an older request
+  // still pending (the oldest is always first), or its own datagrams came
+  // out of sequence.
+  if (!r.reordered && ((r.received == 0 && index > 0) || seq < r.last_seq)) {
+    conn->stats.udp_reordered++;
+    r.reordered = true;
+  }
+  if (seq > r.last_seq) r.last_seq = seq;
+
+  r.parts[seq].assign(buf + 8, len - 8);
+  r.filled[seq] = true;
+  if (++r.received == r.total) complete(index, false);
+}
+
+void UDPTransport::complete(size_t index, bool lost) {
+  request_t &r = requests[index];
+  Operation op = std::move(r.op);
+
+  op.end_time = get_time();
+  op.lost = lost;
+  r.done = true;
+  pending--;
+
+  if (lost) {
+    conn->stats.udp_lost++;
+  } else {
+    string response;
+    for (auto &part: r.parts) response += part;
+
+    size_t pos = 0, eol;
+    while ((eol = response.find("\r\n", pos)) != string::npos) {
+      int len;
+      if (sscanf(response.c_str() + pos, "VALUE %*s %*d %d", &len) == 1) {
+        op.hits++;
+        pos = eol + 2 + len + 2;
+      } else {
+        pos = eol + 2;
+      }
+    }
+  }
+
+  r.parts.clear();
+  r.filled.clear();
+
+  while (requests.size() > 0 && requests.front().done) {
+    requests.pop_front();
+    first_id++;
+  }
+
+  op.origin->complete_op(op);
+}
+
+// Arm the timer for the oldest request still waiting for an answer.
+void UDPTransport::schedule_timeout() {
+  if (requests.size() == 0) return;
+
+  double delay = requests.front().op.start_time + UDP_TIMEOUT - get_time();
+  if (delay < 0.0) delay = 0.0;
+
+  struct timeval tv;
+  double_to_tv(delay, &tv);
+  evtimer_add(timeout_timer, &tv);
+}
+
+void UDPTransport::timeout_callback() {
+  double now = get_time();
+
+  while (requests.size() > 0 &&
+         requests.front().op.start_time + UDP_TIMEOUT <= now)
+    complete(0, true);
+
+  schedule_timeout();
+}
+
+void udp_read_cb(evutil_socket_t fd, short what, void *ptr) {
+  UDPTransport* udp = (UDPTransport*) ptr;
+  udp->read_callback();
+}
+
+void udp_flush_cb(evutil_socket_t fd, short what, void *ptr) {
+  UDPTransport* udp = (UDPTransport*) ptr;
+  udp->flush();
+}
+
+void udp_timeout_cb(evutil_socket_t fd, short what, void *ptr) {
+  UDPTransport* udp = (UDPTransport*) ptr;
+  udp->timeout_callback();
+}
@@ -0,0 +1,74 @@
+/* -*- c++ -*- */
+#ifndef UDPTRANSPORT_H
+#define UDPTRANSPORT_H
+
+#include <inttypes.h>
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#include <event2/event.h>
+
+#include "Operation.h"
+
+using namespace std;
+
+class Connection;
+
+void udp_read_cb(evutil_socket_t fd, short what, void *ptr);
+void udp_flush_cb(evutil_socket_t fd, short what, void *ptr);
+void udp_timeout_cb(evutil_socket_t fd, short what, void *ptr);
+
+/**
+ * Gets over memcached's UDP protocol.  Every datagram starts with an 8-byte
+ * frame header: request id, sequence number, total datagrams and a reserved
+ * field, all 16-bit in network order.  Requests queued during one event
+ * loop pass go out with a single sendmmsg, and answers are read with
+ * recvmmsg.  Answers are matched to requests by id, so they may complete
+ * out of order; requests unanswered after UDP_TIMEOUT are counted as lost.
+ */
+class UDPTransport {
+public:
+  UDPTransport(Connection* _conn, struct event_base* base,
+               const string& hostname, int port);
+  ~UDPTransport();
+
+  void send_get(Operation& op);
+
+  // Gets sent and neither answered nor lost yet.
+  size_t outstanding() { return pending; }
+
+  void read_callback();
+  void flush();
+  void timeout_callback();
+
+private:
+  struct request_t {
+    Operation op;
+    vector<string> parts;
+    vector<bool> filled;
+    int received, total, last_seq;
+    bool done, reordered;
+  };
+
+  Connection *conn;
+  int fd;
+
+  struct event *read_event;
+  struct event *flush_event;
+  struct event *timeout_timer;
+
+  vector<string> outgoing;
+
+  // The request with id i is requests[(uint16_t) (i - first_id)].
+  deque<request_t> requests;
+  uint16_t first_id;
+  size_t pending;
+
+  void receive(const char* buf, int len);
+  void complete(size_t index, bool lost);
+  void schedule_timeout();
+};
+
+#endif
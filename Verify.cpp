@@ -0,0 +1,175 @@
+#include <string.h>
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#endif
+
+#include "KeyRouter.h"
+#include "Verify.h"
+
+static uint32_t crc_table[256];
+
+static void crc32c_table() {
+  for (uint32_t i = 0; i < 256; i++) {
+    uint32_t c = i;
+    for (int k = 0; k < 8; k++) c = c & 1 ? (c >> 1) ^ 0x82f63b78 : c >> 1;
+    crc_table[i] = c;
+  }
+}
+
+static uint32_t crc32c_sw(uint32_t crc, const unsigned char* p, size_t len) {
+  while (len--) crc = crc_table[(crc ^ *p++) & 0xff] ^ (crc >> 8);
+  return crc;
+}
+
+#if defined(__x86_64__)
+__attribute__((target("sse4.2")))
+static uint32_t crc32c_hw(uint32_t crc, const unsigned char* p, size_t len) {
+  uint64_t c = crc;
+
+  for (; len >= 8; p += 8, len -= 8) {
+    uint64_t v;
+    memcpy(&v, p, 8);
+    c = _mm_crc32_u64(c, v);
+  }
+  for (; len; p++, len--) c = _mm_crc32_u8(c, *p);
+
+  return c;
+}
+#endif
+
+uint32_t crc32c(uint32_t crc, const void* buf, size_t len) {
+  static bool hw = false, ready = false;
+
+  if (!ready) {
+#if defined(__x86_64__)
+    hw = __builtin_cpu_supports("sse4.2");
+#endif
+    crc32c_table();
+    ready = true;
+  }
+
+#if defined(__x86_64__)
+  if (hw) return ~crc32c_hw(~crc, (const unsigned char *) buf, len);
+#endif
+  return ~crc32c_sw(~crc, (const unsigned char *) buf, len);
+}
+
+// The newest version of a key known to be stored, and the sets of it in
+// flight: their number in the top PENDING_SHIFT bits, the lowest version
+// among them in the others.
+struct version_t {
+  uint64_t latest;
+  uint64_t pending;
+};
+
+#define PENDING_SHIFT 48
+#define PENDING_VERSION ((1ULL << PENDING_SHIFT) - 1)
+
+static version_t *versions = NULL;
+static int version_keys = 0;
+static uint64_t next_version = 0;
+
+void verify_init(int slots, int keys) {
+  versions = new version_t[(size_t) slots * keys]();
+  version_keys = keys;
+
+  // Pick the implementation before the threads start.
+  crc32c(0, NULL, 0);
+}
+
+// Only record keys are versioned; counters and anything else are not.
+static version_t* version_of(int slot, const char* key) {
+  char *end;
+  uint64_t k = strtoull(key, &end, 10);
+
+  if (*end || end == key || k >= (uint64_t) version_keys) return NULL;
+  return &versions[(size_t) slot * version_keys + k];
+}
+
+uint64_t verify_latest(int slot, const char* key) {
+  version_t *v = version_of(slot, key);
+  return v ? __atomic_load_n(&v->latest, __ATOMIC_ACQUIRE) : 0;
+}
+
+uint64_t verify_issue(int slot, const char* key) {
+  uint64_t version = __atomic_add_fetch(&next_version, 1, __ATOMIC_RELAXED);
+  version_t *v = version_of(slot, key);
+  if (v == NULL) return version;
+
+  uint64_t old = __atomic_load_n(&v->pending, __ATOMIC_RELAXED), now;
+  do {
+    uint64_t n = old >> PENDING_SHIFT;
+    uint64_t lowest = old & PENDING_VERSION;
+    if (n == 0 || version < lowest) lowest = version;
+    now = ((n + 1) << PENDING_SHIFT) | lowest;
+  } while (!__atomic_compare_exchange_n(&v->pending, &old, now, true,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_RELAXED));
+
+  return version;
+}
+
+/**
+ * Sets in flight together may reach the server in any order, so once the
+ * last of them is answered the server holds one of their versions, and
+ * only the lowest of them is certain.  Unstored sets count too, which
+ * errs towards calling fewer values stale.
+ */
+void verify_done(int slot, const char* key) {
+  version_t *v = version_of(slot, key);
+  if (v == NULL) return;
+
+  uint64_t old = __atomic_load_n(&v->pending, __ATOMIC_RELAXED), now;
+  do {
+    now = (old >> PENDING_SHIFT) > 1 ? old - (1ULL << PENDING_SHIFT) : 0;
+  } while (!__atomic_compare_exchange_n(&v->pending, &old, now, true,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_RELAXED));
+  if (now) return;
+
+  uint64_t lowest = old & PENDING_VERSION;
+  uint64_t latest = __atomic_load_n(&v->latest, __ATOMIC_RELAXED);
+  while (latest < lowest &&
+         !__atomic_compare_exchange_n(&v->latest, &latest, lowest, true,
+                                      __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+string verify_header(const char* key, uint64_t version, uint32_t crc) {
+  verify_header_t h;
+
+  h.magic = VERIFY_MAGIC;
+  h.key = hash_key(key);
+  h.version = version;
+  h.crc = crc32c(crc, &h.key, 16);
+
+  return string((const char *) &h, sizeof(h));
+}
+
+void Verifier::begin(const char* key, int len, uint64_t _min_version) {
+  received = 0;
+  length = len;
+  crc = 0;
+  key_hash = hash_key(key);
+  min_version = _min_version;
+}
+
+void Verifier::update(const char* data, size_t n) {
+  if (received < sizeof(header)) {
+    size_t h = min(n, sizeof(header) - received);
+    memcpy((char *) &header + received, data, h);
+    received += h;
+    data += h;
+    n -= h;
+  }
+
+  crc = crc32c(crc, data, n);
+  received += n;
+}
+
+Verifier::result_enum Verifier::finish() {
+  if (length < sizeof(header) || received != length ||
+      header.magic != VERIFY_MAGIC || header.key != key_hash ||
+      header.crc != crc32c(crc, &header.key, 16))
+    return CORRUPT;
+  if (header.version < min_version) return STALE;
+  return OK;
+}
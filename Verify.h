@@ -0,0 +1,58 @@
+/* -*- c++ -*- */
+#ifndef VERIFY_H
+#define VERIFY_H
+
+#include <inttypes.h>
+#include <stddef.h>
+
+#include <string>
+
+using namespace std;
+
+#define VERIFY_MAGIC 0x79666576
+
+/**
+ * With --verify every value starts with this header.  The checksum covers
+ * the payload that follows the header, then the key hash and the version.
+ */
+struct verify_header_t {
+  uint32_t magic;
+  uint32_t crc;
+  uint64_t key;
+  uint64_t version;
+};
+
+// CRC-32C, with the SSE 4.2 instruction when the CPU has it.
+uint32_t crc32c(uint32_t crc, const void* buf, size_t len);
+
+/**
+ * The oldest version of each key that the server is known to hold, in one
+ * table per slot (the servers when every server has its own keys).  Sets
+ * take their version from verify_issue() and report with verify_done()
+ * when they are answered, stored or not.  Shared by all threads.
+ */
+void verify_init(int slots, int keys);
+uint64_t verify_issue(int slot, const char* key);
+void verify_done(int slot, const char* key);
+uint64_t verify_latest(int slot, const char* key);
+
+// The header of a value whose payload has checksum crc.
+string verify_header(const char* key, uint64_t version, uint32_t crc);
+
+// Checks one value as it streams in.
+class Verifier {
+public:
+  enum result_enum { OK, CORRUPT, STALE };
+
+  void begin(const char* key, int len, uint64_t min_version);
+  void update(const char* data, size_t n);
+  result_enum finish();
+
+private:
+  verify_header_t header;
+  size_t received, length;
+  uint32_t crc;
+  uint64_t key_hash, min_version;
+};
+
+#endif
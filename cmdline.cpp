@@ -34,23 +34,61 @@ const char *gengetopt_args_info_versiontext = "";
 const char *gengetopt_args_info_description = "memcached measureing tool for latency measure";
 
 const char *gengetopt_args_info_help[] = {
-  "  -h, --help             Print help and exit",
-  "      --version          Print version and exit",
-  "  -s, --server=STRING    Memcached server hostname[:port].  Repeat to specify\n                           multiple servers.",
-  "  -t, --time=INT         Maximum time to run (seconds).  (default=`5')",
-  "  -K, --keysize=INT      Length of memcached keys.  (default=`30')",
-  "  -V, --valuesize=INT    Length of memcached values.  (default=`200')",
-  "  -r, --records=INT      Number of memcached records to use.  If multiple\n                           memcached servers are given, this number is divided\n                           by the number of servers.  (default=`10000')",
-  "  -R, --ratio=FLOAT      Ratio of set/get commands.  (default=`0.0')",
-  "  -c, --connections=INT  Connections to establish per server.  (default=`1')",
-  "  -d, --depth=INT        Maximum depth to pipeline requests.  (default=`1')",
+  "  -h, --help                    Print help and exit",
+  "      --version                 Print version and exit",
+  "  -s, --server=STRING           Memcached server hostname[:port], or unix:PATH\n                                  for a UNIX domain socket.  Repeat to specify\n                                  multiple servers.",
+  "  -t, --time=INT                Maximum time to run (seconds).  (default=`5')",
+  "      --seed=LONG               Seed of the random numbers.  Every connection\n                                  draws from its own stream of it, so the same\n                                  seed and options send the same requests.\n                                  Defaults to a new seed every run, which is\n                                  printed.",
+  "  -K, --keysize=INT             Length of memcached keys.  (default=`30')",
+  "  -V, --valuesize=INT           Length of memcached values.  (default=`200')",
+  "      --slab-classes=INT        Spread values over the first N slab classes\n                                  that can hold a key in a memcached started\n                                  with --slab-factor and --slab-chunk: each\n                                  key's value makes its item fill a chunk of\n                                  its class.  Overrides --valuesize, and\n                                  latency and throughput are also reported per\n                                  class.  (default=`0')",
+  "      --slab-factor=DOUBLE      Growth factor of the servers' slab classes\n                                  (memcached -f).  (default=`1.25')",
+  "      --slab-chunk=INT          Minimum space for key, value and flags in the\n                                  smallest slab class (memcached -n).\n                                  (default=`48')",
+  "  -r, --records=INT             Number of memcached records to use.  If\n                                  multiple memcached servers are given and\n                                  --hash is none, this number is divided by the\n                                  number of servers.  (default=`10000')",
+  "      --keyspace=INT            Number of keys gets are drawn from.  Keys\n                                  beyond --records are never loaded, so they\n                                  miss until something sets them.  Divided like\n                                  --records.  Defaults to --records, or twice\n                                  that with --hit-ratio.  (default=`0')",
+  "      --hit-ratio=DOUBLE        Fraction of gets that ask for a loaded key; the\n                                  others ask for a key between --records and\n                                  --keyspace.",
+  "      --zipf=DOUBLE             Draw the keys of gets, sets and other commands\n                                  from --keyspace with Zipf popularity of this\n                                  exponent instead of uniformly, so that the\n                                  hot set is also the one rewritten.\n                                  (default=`0')",
+  "      --hot-drift=DOUBLE        Rotate the Zipf ranks by this many keys per\n                                  second, so the hot set slides through the\n                                  keyspace.  (default=`0')",
+  "      --hot-jump=DOUBLE         Move the Zipf hot set to a new random place in\n                                  the keyspace every this many seconds.\n                                  (default=`0')",
+  "      --ttl=STRING              Expiration time in seconds of every set, as a\n                                  distribution like --backend.  0 never\n                                  expires, and times are capped at memcached's\n                                  30 days.",
+  "      --expire-storm=DOUBLE     Make a fraction of the loaded records expire\n                                  together this many seconds after startup,\n                                  connecting and loading included.  Use with\n                                  --report to follow misses and refills around\n                                  that moment.  (default=`0')",
+  "      --expire-fraction=DOUBLE  Fraction of the loaded records that expire in\n                                  the --expire-storm.  (default=`1')",
+  "      --report=DOUBLE           Also print throughput, hit ratio and read\n                                  latency for every interval of this many\n                                  seconds, e.g. to watch evictions when the\n                                  records do not fit in the servers' memory.\n                                  (default=`0')",
+  "  -R, --ratio=FLOAT             Ratio of set/get commands.  (default=`0.0')",
+  "  -c, --connections=INT         Connections to establish per server.\n                                  (default=`1')",
+  "  -d, --depth=INT               Maximum depth to pipeline requests.\n                                  (default=`1')",
+  "      --hash=STRING             How keys are distributed across servers: none\n                                  (every connection uses its own server's\n                                  keys), ketama (the MD5 continuum of\n                                  libketama, for equally weighted servers) or\n                                  jump.  (default=`none')",
+  "      --mix=STRING              Weighted command mix, e.g.\n                                  get=80,set=10,delete=2,incr=2,decr=1,touch=1,append=1,prepend=1,gets=1,cas=1.\n                                  Overrides --ratio.  incr and decr use counter\n                                  keys loaded with 0, and cas is a gets\n                                  followed by a cas, retried on conflict.",
+  "      --backend=STRING          Cache-aside mode: a single-key get that misses\n                                  waits for a backend fetch taking this many\n                                  microseconds, then sets the key.  The whole\n                                  access counts as one get, and the miss row\n                                  shows the fetch and the set alone.  A number\n                                  or fixed:X, uniform:MAX, normal:MEAN,SD,\n                                  exponential:MEAN or pareto:LOC,SCALE,SHAPE.",
+  "  -m, --multiget=INT            Number of keys fetched by each get.  Keys owned\n                                  by different servers are fetched in parallel.\n                                  (default=`1')",
+  "  -F, --fanout=INT              Number of distinct servers each get fans out\n                                  to.  The get completes when the slowest\n                                  server has answered.  (default=`1')",
+  "      --balance=STRING          Treat the servers as replicas that all hold\n                                  every key and pick one for each get: random,\n                                  roundrobin, least (fewest requests\n                                  outstanding) or p2c (the less loaded of two\n                                  random servers).  Sets go to every replica.\n                                  (default=`none')",
+  "      --noreply=INT             Send sets with noreply and follow every N of\n                                  them on a connection with a fence (mn).  A\n                                  set completes when its fence is answered.\n                                  The fence, which loading uses too, needs\n                                  memcached 1.6 or later.  (default=`0')",
+  "      --hedge=STRING            Send a backup copy of a single-key get to\n                                  another connection or replica once it has\n                                  been outstanding this long, either a fixed\n                                  time in microseconds or pNN for the NN-th\n                                  percentile of get latency seen so far.  The\n                                  first answer wins.",
+  "  -T, --threads=INT             Number of threads to spawn.  Connections to\n                                  each server are spread across the threads.\n                                  (default=`1')",
+  "      --ramp=DOUBLE             Open at most this many connections per second,\n                                  so that large connection counts do not\n                                  overrun the servers' accept queues.  0 opens\n                                  them all at once.  (default=`0')",
+  "      --churn=DOUBLE            Fraction of the connections to close and reopen\n                                  every second.  A connection stops issuing\n                                  requests and waits for its answers before it\n                                  reconnects, and with --hash, --fanout or\n                                  --balance the connections that send requests\n                                  through it wait with it.  The stay row holds\n                                  the gets of connections that have not\n                                  reconnected in the previous second.\n                                  (default=`0')",
+  "      --verify                  Start every value with its key, a version and a\n                                  CRC-32C checksum, and check every value read:\n                                  report values that are corrupt or older than\n                                  every set answered when a get was sent,\n                                  except sets that raced with another set of\n                                  the same key.  (default=off)",
+  "      --udp                     Send gets over UDP.  Sets and loading still use\n                                  TCP, and gets unanswered after 250ms are\n                                  counted as lost.  (default=off)",
+  "      --tls                     Connect over TLS.  Certificates are not\n                                  verified.  (default=off)",
+  "      --tls-resume              Resume each server's latest TLS session on new\n                                  connections instead of doing a full\n                                  handshake.  (default=off)",
+  "      --sasl=STRING             Authenticate every connection with\n                                  USER:PASSWORD using the text protocol's\n                                  authentication command (memcached -Y).",
+  "      --metrics=INT             Serve live QPS, hits, misses, bytes and get/set\n                                  latency histograms in the Prometheus text\n                                  format at http://127.0.0.1:PORT/metrics while\n                                  the test runs.",
+  "      --trace-slow=STRING       Keep the context of every request slower than\n                                  this, either a fixed time in microseconds or\n                                  pNN for the NN-th percentile of its command's\n                                  latency seen so far: its key, value size,\n                                  connection, the requests ahead of and behind\n                                  it on the connection, and when it was sent\n                                  and answered.  The slowest are printed, with\n                                  slow requests counted by connection and key.",
+  "      --record=STRING           Write every request of the measurement to FILE:\n                                  when it was sent, its latency, type, key,\n                                  value size, connection and the requests ahead\n                                  of it, as the binary records of Record.h.\n                                  Threads hand them to a writer thread without\n                                  waiting, and what the writer cannot keep up\n                                  with is dropped and counted.",
+  "      --output=STRING           Format of the results: text, json or csv.  json\n                                  and csv also hold the options given, every\n                                  latency bucket and --percentiles, for scripts\n                                  that compare or merge runs, besides the\n                                  --report intervals, server load and slab\n                                  classes of the text report.  (default=`text')",
+  "      --percentiles=STRING      Latency percentiles reported by json and csv\n                                  output.\n                                  (default=`1,5,10,50,90,95,99,99.9,99.99')",
+  "      --noload                  Skip the database loading phase, e.g. when the\n                                  servers are already warm.  (default=off)",
     0
 };
 
 typedef enum {ARG_NO
+  , ARG_FLAG
   , ARG_STRING
   , ARG_INT
+  , ARG_LONG
   , ARG_FLOAT
+  , ARG_DOUBLE
 } cmdline_parser_arg_type;
 
 static
@@ -75,12 +113,47 @@ void clear_given (struct gengetopt_args_info *args_info)
   args_info->version_given = 0 ;
   args_info->server_given = 0 ;
   args_info->time_given = 0 ;
+  args_info->seed_given = 0 ;
   args_info->keysize_given = 0 ;
   args_info->valuesize_given = 0 ;
+  args_info->slab_classes_given = 0 ;
+  args_info->slab_factor_given = 0 ;
+  args_info->slab_chunk_given = 0 ;
   args_info->records_given = 0 ;
+  args_info->keyspace_given = 0 ;
+  args_info->hit_ratio_given = 0 ;
+  args_info->zipf_given = 0 ;
+  args_info->hot_drift_given = 0 ;
+  args_info->hot_jump_given = 0 ;
+  args_info->ttl_given = 0 ;
+  args_info->expire_storm_given = 0 ;
+  args_info->expire_fraction_given = 0 ;
+  args_info->report_given = 0 ;
   args_info->ratio_given = 0 ;
   args_info->connections_given = 0 ;
   args_info->depth_given = 0 ;
+  args_info->hash_given = 0 ;
+  args_info->mix_given = 0 ;
+  args_info->backend_given = 0 ;
+  args_info->multiget_given = 0 ;
+  args_info->fanout_given = 0 ;
+  args_info->balance_given = 0 ;
+  args_info->noreply_given = 0 ;
+  args_info->hedge_given = 0 ;
+  args_info->threads_given = 0 ;
+  args_info->ramp_given = 0 ;
+  args_info->churn_given = 0 ;
+  args_info->verify_given = 0 ;
+  args_info->udp_given = 0 ;
+  args_info->tls_given = 0 ;
+  args_info->tls_resume_given = 0 ;
+  args_info->sasl_given = 0 ;
+  args_info->metrics_given = 0 ;
+  args_info->trace_slow_given = 0 ;
+  args_info->record_given = 0 ;
+  args_info->output_given = 0 ;
+  args_info->percentiles_given = 0 ;
+  args_info->noload_given = 0 ;
 }
 
 static
@@ -91,18 +164,80 @@ void clear_args (struct gengetopt_args_info *args_info)
   args_info->server_orig = NULL;
   args_info->time_arg = 5;
   args_info->time_orig = NULL;
+  args_info->seed_orig = NULL;
   args_info->keysize_arg = 30;
   args_info->keysize_orig = NULL;
   args_info->valuesize_arg = 200;
   args_info->valuesize_orig = NULL;
+  args_info->slab_classes_arg = 0;
+  args_info->slab_classes_orig = NULL;
+  args_info->slab_factor_arg = 1.25;
+  args_info->slab_factor_orig = NULL;
+  args_info->slab_chunk_arg = 48;
+  args_info->slab_chunk_orig = NULL;
   args_info->records_arg = 10000;
   args_info->records_orig = NULL;
+  args_info->keyspace_arg = 0;
+  args_info->keyspace_orig = NULL;
+  args_info->hit_ratio_orig = NULL;
+  args_info->zipf_arg = 0;
+  args_info->zipf_orig = NULL;
+  args_info->hot_drift_arg = 0;
+  args_info->hot_drift_orig = NULL;
+  args_info->hot_jump_arg = 0;
+  args_info->hot_jump_orig = NULL;
+  args_info->ttl_arg = NULL;
+  args_info->ttl_orig = NULL;
+  args_info->expire_storm_arg = 0;
+  args_info->expire_storm_orig = NULL;
+  args_info->expire_fraction_arg = 1;
+  args_info->expire_fraction_orig = NULL;
+  args_info->report_arg = 0;
+  args_info->report_orig = NULL;
   args_info->ratio_arg = 0.0;
   args_info->ratio_orig = NULL;
   args_info->connections_arg = 1;
   args_info->connections_orig = NULL;
   args_info->depth_arg = 1;
   args_info->depth_orig = NULL;
+  args_info->hash_arg = gengetopt_strdup ("none");
+  args_info->hash_orig = NULL;
+  args_info->mix_arg = NULL;
+  args_info->mix_orig = NULL;
+  args_info->backend_arg = NULL;
+  args_info->backend_orig = NULL;
+  args_info->multiget_arg = 1;
+  args_info->multiget_orig = NULL;
+  args_info->fanout_arg = 1;
+  args_info->fanout_orig = NULL;
+  args_info->balance_arg = gengetopt_strdup ("none");
+  args_info->balance_orig = NULL;
+  args_info->noreply_arg = 0;
+  args_info->noreply_orig = NULL;
+  args_info->hedge_arg = NULL;
+  args_info->hedge_orig = NULL;
+  args_info->threads_arg = 1;
+  args_info->threads_orig = NULL;
+  args_info->ramp_arg = 0;
+  args_info->ramp_orig = NULL;
+  args_info->churn_arg = 0;
+  args_info->churn_orig = NULL;
+  args_info->verify_flag = 0;
+  args_info->udp_flag = 0;
+  args_info->tls_flag = 0;
+  args_info->tls_resume_flag = 0;
+  args_info->sasl_arg = NULL;
+  args_info->sasl_orig = NULL;
+  args_info->metrics_orig = NULL;
+  args_info->trace_slow_arg = NULL;
+  args_info->trace_slow_orig = NULL;
+  args_info->record_arg = NULL;
+  args_info->record_orig = NULL;
+  args_info->output_arg = gengetopt_strdup ("text");
+  args_info->output_orig = NULL;
+  args_info->percentiles_arg = gengetopt_strdup ("1,5,10,50,90,95,99,99.9,99.99");
+  args_info->percentiles_orig = NULL;
+  args_info->noload_flag = 0;
   
 }
 
@@ -117,12 +252,47 @@ void init_args_info(struct gengetopt_args_info *args_info)
   args_info->server_min = 0;
   args_info->server_max = 0;
   args_info->time_help = gengetopt_args_info_help[3] ;
-  args_info->keysize_help = gengetopt_args_info_help[4] ;
-  args_info->valuesize_help = gengetopt_args_info_help[5] ;
-  args_info->records_help = gengetopt_args_info_help[6] ;
-  args_info->ratio_help = gengetopt_args_info_help[7] ;
-  args_info->connections_help = gengetopt_args_info_help[8] ;
-  args_info->depth_help = gengetopt_args_info_help[9] ;
+  args_info->seed_help = gengetopt_args_info_help[4] ;
+  args_info->keysize_help = gengetopt_args_info_help[5] ;
+  args_info->valuesize_help = gengetopt_args_info_help[6] ;
+  args_info->slab_classes_help = gengetopt_args_info_help[7] ;
+  args_info->slab_factor_help = gengetopt_args_info_help[8] ;
+  args_info->slab_chunk_help = gengetopt_args_info_help[9] ;
+  args_info->records_help = gengetopt_args_info_help[10] ;
+  args_info->keyspace_help = gengetopt_args_info_help[11] ;
+  args_info->hit_ratio_help = gengetopt_args_info_help[12] ;
+  args_info->zipf_help = gengetopt_args_info_help[13] ;
+  args_info->hot_drift_help = gengetopt_args_info_help[14] ;
+  args_info->hot_jump_help = gengetopt_args_info_help[15] ;
+  args_info->ttl_help = gengetopt_args_info_help[16] ;
+  args_info->expire_storm_help = gengetopt_args_info_help[17] ;
+  args_info->expire_fraction_help = gengetopt_args_info_help[18] ;
+  args_info->report_help = gengetopt_args_info_help[19] ;
+  args_info->ratio_help = gengetopt_args_info_help[20] ;
+  args_info->connections_help = gengetopt_args_info_help[21] ;
+  args_info->depth_help = gengetopt_args_info_help[22] ;
+  args_info->hash_help = gengetopt_args_info_help[23] ;
+  args_info->mix_help = gengetopt_args_info_help[24] ;
+  args_info->backend_help = gengetopt_args_info_help[25] ;
+  args_info->multiget_help = gengetopt_args_info_help[26] ;
+  args_info->fanout_help = gengetopt_args_info_help[27] ;
+  args_info->balance_help = gengetopt_args_info_help[28] ;
+  args_info->noreply_help = gengetopt_args_info_help[29] ;
+  args_info->hedge_help = gengetopt_args_info_help[30] ;
+  args_info->threads_help = gengetopt_args_info_help[31] ;
+  args_info->ramp_help = gengetopt_args_info_help[32] ;
+  args_info->churn_help = gengetopt_args_info_help[33] ;
+  args_info->verify_help = gengetopt_args_info_help[34] ;
+  args_info->udp_help = gengetopt_args_info_help[35] ;
+  args_info->tls_help = gengetopt_args_info_help[36] ;
+  args_info->tls_resume_help = gengetopt_args_info_help[37] ;
+  args_info->sasl_help = gengetopt_args_info_help[38] ;
+  args_info->metrics_help = gengetopt_args_info_help[39] ;
+  args_info->trace_slow_help = gengetopt_args_info_help[40] ;
+  args_info->record_help = gengetopt_args_info_help[41] ;
+  args_info->output_help = gengetopt_args_info_help[42] ;
+  args_info->percentiles_help = gengetopt_args_info_help[43] ;
+  args_info->noload_help = gengetopt_args_info_help[44] ;
   
 }
 
@@ -204,7 +374,9 @@ free_string_field (char **s)
 /** @brief generic value variable */
 union generic_value {
     int int_arg;
+    long long_arg;
     float float_arg;
+    double double_arg;
     char *string_arg;
     const char *default_string_arg;
 };
@@ -254,12 +426,53 @@ cmdline_parser_release (struct gengetopt_args_info *args_info)
 
   free_multiple_string_field (args_info->server_given, &(args_info->server_arg), &(args_info->server_orig));
   free_string_field (&(args_info->time_orig));
+  free_string_field (&(args_info->seed_orig));
   free_string_field (&(args_info->keysize_orig));
   free_string_field (&(args_info->valuesize_orig));
+  free_string_field (&(args_info->slab_classes_orig));
+  free_string_field (&(args_info->slab_factor_orig));
+  free_string_field (&(args_info->slab_chunk_orig));
   free_string_field (&(args_info->records_orig));
+  free_string_field (&(args_info->keyspace_orig));
+  free_string_field (&(args_info->hit_ratio_orig));
+  free_string_field (&(args_info->zipf_orig));
+  free_string_field (&(args_info->hot_drift_orig));
+  free_string_field (&(args_info->hot_jump_orig));
+  free_string_field (&(args_info->ttl_arg));
+  free_string_field (&(args_info->ttl_orig));
+  free_string_field (&(args_info->expire_storm_orig));
+  free_string_field (&(args_info->expire_fraction_orig));
+  free_string_field (&(args_info->report_orig));
   free_string_field (&(args_info->ratio_orig));
   free_string_field (&(args_info->connections_orig));
   free_string_field (&(args_info->depth_orig));
+  free_string_field (&(args_info->hash_arg));
+  free_string_field (&(args_info->hash_orig));
+  free_string_field (&(args_info->mix_arg));
+  free_string_field (&(args_info->mix_orig));
+  free_string_field (&(args_info->backend_arg));
+  free_string_field (&(args_info->backend_orig));
+  free_string_field (&(args_info->multiget_orig));
+  free_string_field (&(args_info->fanout_orig));
+  free_string_field (&(args_info->balance_arg));
+  free_string_field (&(args_info->balance_orig));
+  free_string_field (&(args_info->noreply_orig));
+  free_string_field (&(args_info->hedge_arg));
+  free_string_field (&(args_info->hedge_orig));
+  free_string_field (&(args_info->threads_orig));
+  free_string_field (&(args_info->ramp_orig));
+  free_string_field (&(args_info->churn_orig));
+  free_string_field (&(args_info->sasl_arg));
+  free_string_field (&(args_info->sasl_orig));
+  free_string_field (&(args_info->metrics_orig));
+  free_string_field (&(args_info->trace_slow_arg));
+  free_string_field (&(args_info->trace_slow_orig));
+  free_string_field (&(args_info->record_arg));
+  free_string_field (&(args_info->record_orig));
+  free_string_field (&(args_info->output_arg));
+  free_string_field (&(args_info->output_orig));
+  free_string_field (&(args_info->percentiles_arg));
+  free_string_field (&(args_info->percentiles_orig));
   
   
 
@@ -305,18 +518,88 @@ cmdline_parser_dump(FILE *outfile, struct gengetopt_args_info *args_info)
   write_multiple_into_file(outfile, args_info->server_given, "server", args_info->server_orig, 0);
   if (args_info->time_given)
     write_into_file(outfile, "time", args_info->time_orig, 0);
+  if (args_info->seed_given)
+    write_into_file(outfile, "seed", args_info->seed_orig, 0);
   if (args_info->keysize_given)
     write_into_file(outfile, "keysize", args_info->keysize_orig, 0);
   if (args_info->valuesize_given)
     write_into_file(outfile, "valuesize", args_info->valuesize_orig, 0);
+  if (args_info->slab_classes_given)
+    write_into_file(outfile, "slab-classes", args_info->slab_classes_orig, 0);
+  if (args_info->slab_factor_given)
+    write_into_file(outfile, "slab-factor", args_info->slab_factor_orig, 0);
+  if (args_info->slab_chunk_given)
+    write_into_file(outfile, "slab-chunk", args_info->slab_chunk_orig, 0);
   if (args_info->records_given)
     write_into_file(outfile, "records", args_info->records_orig, 0);
+  if (args_info->keyspace_given)
+    write_into_file(outfile, "keyspace", args_info->keyspace_orig, 0);
+  if (args_info->hit_ratio_given)
+    write_into_file(outfile, "hit-ratio", args_info->hit_ratio_orig, 0);
+  if (args_info->zipf_given)
+    write_into_file(outfile, "zipf", args_info->zipf_orig, 0);
+  if (args_info->hot_drift_given)
+    write_into_file(outfile, "hot-drift", args_info->hot_drift_orig, 0);
+  if (args_info->hot_jump_given)
+    write_into_file(outfile, "hot-jump", args_info->hot_jump_orig, 0);
+  if (args_info->ttl_given)
+    write_into_file(outfile, "ttl", args_info->ttl_orig, 0);
+  if (args_info->expire_storm_given)
+    write_into_file(outfile, "expire-storm", args_info->expire_storm_orig, 0);
+  if (args_info->expire_fraction_given)
+    write_into_file(outfile, "expire-fraction", args_info->expire_fraction_orig, 0);
+  if (args_info->report_given)
+    write_into_file(outfile, "report", args_info->report_orig, 0);
   if (args_info->ratio_given)
     write_into_file(outfile, "ratio", args_info->ratio_orig, 0);
   if (args_info->connections_given)
     write_into_file(outfile, "connections", args_info->connections_orig, 0);
   if (args_info->depth_given)
     write_into_file(outfile, "depth", args_info->depth_orig, 0);
+  if (args_info->hash_given)
+    write_into_file(outfile, "hash", args_info->hash_orig, 0);
+  if (args_info->mix_given)
+    write_into_file(outfile, "mix", args_info->mix_orig, 0);
+  if (args_info->backend_given)
+    write_into_file(outfile, "backend", args_info->backend_orig, 0);
+  if (args_info->multiget_given)
+    write_into_file(outfile, "multiget", args_info->multiget_orig, 0);
+  if (args_info->fanout_given)
+    write_into_file(outfile, "fanout", args_info->fanout_orig, 0);
+  if (args_info->balance_given)
+    write_into_file(outfile, "balance", args_info->balance_orig, 0);
+  if (args_info->noreply_given)
+    write_into_file(outfile, "noreply", args_info->noreply_orig, 0);
+  if (args_info->hedge_given)
+    write_into_file(outfile, "hedge", args_info->hedge_orig, 0);
+  if (args_info->threads_given)
+    write_into_file(outfile, "threads", args_info->threads_orig, 0);
+  if (args_info->ramp_given)
+    write_into_file(outfile, "ramp", args_info->ramp_orig, 0);
+  if (args_info->churn_given)
+    write_into_file(outfile, "churn", args_info->churn_orig, 0);
+  if (args_info->verify_given)
+    write_into_file(outfile, "verify", 0, 0 );
+  if (args_info->udp_given)
+    write_into_file(outfile, "udp", 0, 0 );
+  if (args_info->tls_given)
+    write_into_file(outfile, "tls", 0, 0 );
+  if (args_info->tls_resume_given)
+    write_into_file(outfile, "tls-resume", 0, 0 );
+  if (args_info->sasl_given)
+    write_into_file(outfile, "sasl", args_info->sasl_orig, 0);
+  if (args_info->metrics_given)
+    write_into_file(outfile, "metrics", args_info->metrics_orig, 0);
+  if (args_info->trace_slow_given)
+    write_into_file(outfile, "trace-slow", args_info->trace_slow_orig, 0);
+  if (args_info->record_given)
+    write_into_file(outfile, "record", args_info->record_orig, 0);
+  if (args_info->output_given)
+    write_into_file(outfile, "output", args_info->output_orig, 0);
+  if (args_info->percentiles_given)
+    write_into_file(outfile, "percentiles", args_info->percentiles_orig, 0);
+  if (args_info->noload_given)
+    write_into_file(outfile, "noload", 0, 0 );
   
 
   i = EXIT_SUCCESS;
@@ -643,12 +926,21 @@ int update_arg(void *field, char **orig_field,
     val = possible_values[found];
 
   switch(arg_type) {
+  case ARG_FLAG:
+    *((int *)field) = !*((int *)field);
+    break;
   case ARG_INT:
     if (val) *((int *)field) = strtol (val, &stop_char, 0);
     break;
+  case ARG_LONG:
+    if (val) *((long *)field) = (long)strtol (val, &stop_char, 0);
+    break;
   case ARG_FLOAT:
     if (val) *((float *)field) = (float)strtod (val, &stop_char);
     break;
+  case ARG_DOUBLE:
+    if (val) *((double *)field) = strtod (val, &stop_char);
+    break;
   case ARG_STRING:
     if (val) {
       string_field = (char **)field;
@@ -664,7 +956,9 @@ int update_arg(void *field, char **orig_field,
   /* check numeric conversion */
   switch(arg_type) {
   case ARG_INT:
+  case ARG_LONG:
   case ARG_FLOAT:
+  case ARG_DOUBLE:
     if (val && !(stop_char && *stop_char == '\0')) {
       fprintf(stderr, "%s: invalid numeric value: %s\n", package_name, val);
       return 1; /* failure */
@@ -677,6 +971,7 @@ int update_arg(void *field, char **orig_field,
   /* store the original value */
   switch(arg_type) {
   case ARG_NO:
+  case ARG_FLAG:
     break;
   default:
     if (value && orig_field) {
@@ -778,8 +1073,12 @@ void update_multiple_arg(void *field, char ***orig_field,
     switch(arg_type) {
     case ARG_INT:
       *((int **)field) = (int *)realloc (*((int **)field), (field_given + prev_given) * sizeof (int)); break;
+    case ARG_LONG:
+      *((long **)field) = (long *)realloc (*((long **)field), (field_given + prev_given) * sizeof (long)); break;
     case ARG_FLOAT:
       *((float **)field) = (float *)realloc (*((float **)field), (field_given + prev_given) * sizeof (float)); break;
+    case ARG_DOUBLE:
+      *((double **)field) = (double *)realloc (*((double **)field), (field_given + prev_given) * sizeof (double)); break;
     case ARG_STRING:
       *((char ***)field) = (char **)realloc (*((char ***)field), (field_given + prev_given) * sizeof (char *)); break;
     default:
@@ -793,8 +1092,12 @@ void update_multiple_arg(void *field, char ***orig_field,
         switch(arg_type) {
         case ARG_INT:
           (*((int **)field))[i + field_given] = tmp->arg.int_arg; break;
+        case ARG_LONG:
+          (*((long **)field))[i + field_given] = tmp->arg.long_arg; break;
         case ARG_FLOAT:
           (*((float **)field))[i + field_given] = tmp->arg.float_arg; break;
+        case ARG_DOUBLE:
+          (*((double **)field))[i + field_given] = tmp->arg.double_arg; break;
         case ARG_STRING:
           (*((char ***)field))[i + field_given] = tmp->arg.string_arg; break;
         default:
@@ -813,12 +1116,24 @@ void update_multiple_arg(void *field, char ***orig_field,
           (*((int **)field))[0] = default_value->int_arg; 
         }
         break;
+      case ARG_LONG:
+        if (! *((long **)field)) {
+          *((long **)field) = (long *)malloc (sizeof (long));
+          (*((long **)field))[0] = default_value->long_arg;
+        }
+        break;
       case ARG_FLOAT:
         if (! *((float **)field)) {
           *((float **)field) = (float *)malloc (sizeof (float));
           (*((float **)field))[0] = default_value->float_arg;
         }
         break;
+      case ARG_DOUBLE:
+        if (! *((double **)field)) {
+          *((double **)field) = (double *)malloc (sizeof (double));
+          (*((double **)field))[0] = default_value->double_arg;
+        }
+        break;
       case ARG_STRING:
         if (! *((char ***)field)) {
           *((char ***)field) = (char **)malloc (sizeof (char *));
@@ -877,16 +1192,51 @@ cmdline_parser_internal (
         { "version",	0, NULL, 0 },
         { "server",	1, NULL, 's' },
         { "time",	1, NULL, 't' },
+        { "seed",	1, NULL, 0 },
         { "keysize",	1, NULL, 'K' },
         { "valuesize",	1, NULL, 'V' },
+        { "slab-classes",	1, NULL, 0 },
+        { "slab-factor",	1, NULL, 0 },
+        { "slab-chunk",	1, NULL, 0 },
         { "records",	1, NULL, 'r' },
+        { "keyspace",	1, NULL, 0 },
+        { "hit-ratio",	1, NULL, 0 },
+        { "zipf",	1, NULL, 0 },
+        { "hot-drift",	1, NULL, 0 },
+        { "hot-jump",	1, NULL, 0 },
+        { "ttl",	1, NULL, 0 },
+        { "expire-storm",	1, NULL, 0 },
+        { "expire-fraction",	1, NULL, 0 },
+        { "report",	1, NULL, 0 },
         { "ratio",	1, NULL, 'R' },
         { "connections",	1, NULL, 'c' },
         { "depth",	1, NULL, 'd' },
+        { "hash",	1, NULL, 0 },
+        { "mix",	1, NULL, 0 },
+        { "backend",	1, NULL, 0 },
+        { "multiget",	1, NULL, 'm' },
+        { "fanout",	1, NULL, 'F' },
+        { "balance",	1, NULL, 0 },
+        { "noreply",	1, NULL, 0 },
+        { "hedge",	1, NULL, 0 },
+        { "threads",	1, NULL, 'T' },
+        { "ramp",	1, NULL, 0 },
+        { "churn",	1, NULL, 0 },
+        { "verify",	0, NULL, 0 },
+        { "udp",	0, NULL, 0 },
+        { "tls",	0, NULL, 0 },
+        { "tls-resume",	0, NULL, 0 },
+        { "sasl",	1, NULL, 0 },
+        { "metrics",	1, NULL, 0 },
+        { "trace-slow",	1, NULL, 0 },
+        { "record",	1, NULL, 0 },
+        { "output",	1, NULL, 0 },
+        { "percentiles",	1, NULL, 0 },
+        { "noload",	0, NULL, 0 },
         { 0,  0, 0, 0 }
       };
 
-      c = getopt_long (argc, argv, "hs:t:K:V:r:R:c:d:", long_options, &option_index);
+      c = getopt_long (argc, argv, "hs:t:K:V:r:R:c:d:m:F:T:", long_options, &option_index);
 
       if (c == -1) break;	/* Exit from `while (1)' loop.  */
 
@@ -897,7 +1247,7 @@ cmdline_parser_internal (
           cmdline_parser_free (&local_args_info);
           exit (EXIT_SUCCESS);
 
-        case 's':	/* Memcached server hostname[:port].  Repeat to specify multiple servers..  */
+        case 's':	/* Memcached server hostname[:port], or unix:PATH for a UNIX domain socket.  Repeat to specify multiple servers..  */
         
           if (update_multiple_arg_temp(&server_list, 
               &(local_args_info.server_given), optarg, 0, 0, ARG_STRING,
@@ -942,7 +1292,7 @@ cmdline_parser_internal (
             goto failure;
         
           break;
-        case 'r':	/* Number of memcached records to use.  If multiple memcached servers are given, this number is divided by the number of servers..  */
+        case 'r':	/* Number of memcached records to use.  If multiple memcached servers are given and --hash is none, this number is divided by the number of servers..  */
         
         
           if (update_arg( (void *)&(args_info->records_arg), 
@@ -990,6 +1340,42 @@ cmdline_parser_internal (
             goto failure;
         
           break;
+        case 'm':	/* Number of keys fetched by each get.  Keys owned by different servers are fetched in parallel..  */
+        
+        
+          if (update_arg( (void *)&(args_info->multiget_arg), 
+               &(args_info->multiget_orig), &(args_info->multiget_given),
+              &(local_args_info.multiget_given), optarg, 0, "1", ARG_INT,
+              check_ambiguity, override, 0, 0,
+              "multiget", 'm',
+              additional_error))
+            goto failure;
+        
+          break;
+        case 'F':	/* Number of distinct servers each get fans out to.  The get completes when the slowest server has answered..  */
+        
+        
+          if (update_arg( (void *)&(args_info->fanout_arg), 
+               &(args_info->fanout_orig), &(args_info->fanout_given),
+              &(local_args_info.fanout_given), optarg, 0, "1", ARG_INT,
+              check_ambiguity, override, 0, 0,
+              "fanout", 'F',
+              additional_error))
+            goto failure;
+        
+          break;
+        case 'T':	/* Number of threads to spawn.  Connections to each server are spread across the threads..  */
+        
+        
+          if (update_arg( (void *)&(args_info->threads_arg), 
+               &(args_info->threads_orig), &(args_info->threads_given),
+              &(local_args_info.threads_given), optarg, 0, "1", ARG_INT,
+              check_ambiguity, override, 0, 0,
+              "threads", 'T',
+              additional_error))
+            goto failure;
+        
+          break;
 
         case 0:	/* Long option with no short option */
           if (strcmp (long_options[option_index].name, "version") == 0) {
@@ -998,6 +1384,446 @@ cmdline_parser_internal (
             exit (EXIT_SUCCESS);
           }
 
+          /* Seed of the random numbers.  Every connection draws from its own stream of it, so the same seed and options send the same requests.  Defaults to a new seed every run, which is printed..  */
+          if (strcmp (long_options[option_index].name, "seed") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->seed_arg), 
+                 &(args_info->seed_orig), &(args_info->seed_given),
+                &(local_args_info.seed_given), optarg, 0, 0, ARG_LONG,
+                check_ambiguity, override, 0, 0,
+                "seed", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* Spread values over the first N slab classes that can hold a key in a memcached started with --slab-factor and --slab-chunk: each key's value makes its item fill a chunk of its class.  Overrides --valuesize, and latency and throughput are also reported per class..  */
+          else if (strcmp (long_options[option_index].name, "slab-classes") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->slab_classes_arg), 
+                 &(args_info->slab_classes_orig), &(args_info->slab_classes_given),
+                &(local_args_info.slab_classes_given), optarg, 0, "0", ARG_INT,
+                check_ambiguity, override, 0, 0,
+                "slab-classes", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* Growth factor of the servers' slab classes (memcached -f)..  */
+          else if (strcmp (long_options[option_index].name, "slab-factor") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->slab_factor_arg), 
+                 &(args_info->slab_factor_orig), &(args_info->slab_factor_given),
+                &(local_args_info.slab_factor_given), optarg, 0, "1.25", ARG_DOUBLE,
+                check_ambiguity, override, 0, 0,
+                "slab-factor", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* Minimum space for key, value and flags in the smallest slab class (memcached -n)..  */
+          else if (strcmp (long_options[option_index].name, "slab-chunk") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->slab_chunk_arg), 
+                 &(args_info->slab_chunk_orig), &(args_info->slab_chunk_given),
+                &(local_args_info.slab_chunk_given), optarg, 0, "48", ARG_INT,
+                check_ambiguity, override, 0, 0,
+                "slab-chunk", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* Number of keys gets are drawn from.  Keys beyond --records are never loaded, so they miss until something sets them.  Divided like --records.  Defaults to --records, or twice that with --hit-ratio..  */
+          else if (strcmp (long_options[option_index].name, "keyspace") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->keyspace_arg), 
+                 &(args_info->keyspace_orig), &(args_info->keyspace_given),
+                &(local_args_info.keyspace_given), optarg, 0, "0", ARG_INT,
+                check_ambiguity, override, 0, 0,
+                "keyspace", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* Fraction of gets that ask for a loaded key; the others ask for a key between --records and --keyspace..  */
+          else if (strcmp (long_options[option_index].name, "hit-ratio") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->hit_ratio_arg), 
+                 &(args_info->hit_ratio_orig), &(args_info->hit_ratio_given),
+                &(local_args_info.hit_ratio_given), optarg, 0, 0, ARG_DOUBLE,
+                check_ambiguity, override, 0, 0,
+                "hit-ratio", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* Draw the keys of gets, sets and other commands from --keyspace with Zipf popularity of this exponent instead of uniformly, so that the hot set is also the one rewritten..  */
+          else if (strcmp (long_options[option_index].name, "zipf") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->zipf_arg), 
+                 &(args_info->zipf_orig), &(args_info->zipf_given),
+                &(local_args_info.zipf_given), optarg, 0, "0", ARG_DOUBLE,
+                check_ambiguity, override, 0, 0,
+                "zipf", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* Rotate the Zipf ranks by this many keys per second, so the hot set slides through the keyspace..  */
+          else if (strcmp (long_options[option_index].name, "hot-drift") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->hot_drift_arg), 
+                 &(args_info->hot_drift_orig), &(args_info->hot_drift_given),
+                &(local_args_info.hot_drift_given), optarg, 0, "0", ARG_DOUBLE,
+                check_ambiguity, override, 0, 0,
+                "hot-drift", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* Move the Zipf hot set to a new random place in the keyspace every this many seconds..  */
+          else if (strcmp (long_options[option_index].name, "hot-jump") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->hot_jump_arg), 
+                 &(args_info->hot_jump_orig), &(args_info->hot_jump_given),
+                &(local_args_info.hot_jump_given), optarg, 0, "0", ARG_DOUBLE,
+                check_ambiguity, override, 0, 0,
+                "hot-jump", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* Expiration time in seconds of every set, as a distribution like --backend.  0 never expires, and times are capped at memcached's 30 days..  */
+          else if (strcmp (long_options[option_index].name, "ttl") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->ttl_arg), 
+                 &(args_info->ttl_orig), &(args_info->ttl_given),
+                &(local_args_info.ttl_given), optarg, 0, 0, ARG_STRING,
+                check_ambiguity, override, 0, 0,
+                "ttl", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* Make a fraction of the loaded records expire together this many seconds after startup, connecting and loading included.  Use with --report to follow misses and refills around that moment..  */
+          else if (strcmp (long_options[option_index].name, "expire-storm") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->expire_storm_arg), 
+                 &(args_info->expire_storm_orig), &(args_info->expire_storm_given),
+                &(local_args_info.expire_storm_given), optarg, 0, "0", ARG_DOUBLE,
+                check_ambiguity, override, 0, 0,
+                "expire-storm", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* Fraction of the loaded records that expire in the --expire-storm..  */
+          else if (strcmp (long_options[option_index].name, "expire-fraction") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->expire_fraction_arg), 
+                 &(args_info->expire_fraction_orig), &(args_info->expire_fraction_given),
+                &(local_args_info.expire_fraction_given), optarg, 0, "1", ARG_DOUBLE,
+                check_ambiguity, override, 0, 0,
+                "expire-fraction", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* Also print throughput, hit ratio and read latency for every interval of this many seconds, e.g. to watch evictions when the records do not fit in the servers' memory..  */
+          else if (strcmp (long_options[option_index].name, "report") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->report_arg), 
+                 &(args_info->report_orig), &(args_info->report_given),
+                &(local_args_info.report_given), optarg, 0, "0", ARG_DOUBLE,
+                check_ambiguity, override, 0, 0,
+                "report", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* How keys are distributed across servers: none (every connection uses its own server's keys), ketama (the MD5 continuum of libketama, for equally weighted servers) or jump..  */
+          else if (strcmp (long_options[option_index].name, "hash") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->hash_arg), 
+                 &(args_info->hash_orig), &(args_info->hash_given),
+                &(local_args_info.hash_given), optarg, 0, "none", ARG_STRING,
+                check_ambiguity, override, 0, 0,
+                "hash", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* Weighted command mix, e.g. get=80,set=10,delete=2,incr=2,decr=1,touch=1,append=1,prepend=1,gets=1,cas=1. Overrides --ratio.  incr and decr use counter keys loaded with 0, and cas is a gets followed by a cas, retried on conflict..  */
+          else if (strcmp (long_options[option_index].name, "mix") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->mix_arg), 
+                 &(args_info->mix_orig), &(args_info->mix_given),
+                &(local_args_info.mix_given), optarg, 0, 0, ARG_STRING,
+                check_ambiguity, override, 0, 0,
+                "mix", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* Cache-aside mode: a single-key get that misses waits for a backend fetch taking this many microseconds, then sets the key.  The whole access counts as one get, and the miss row shows the fetch and the set alone.  A number or fixed:X, uniform:MAX, normal:MEAN,SD, exponential:MEAN or pareto:LOC,SCALE,SHAPE..  */
+          else if (strcmp (long_options[option_index].name, "backend") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->backend_arg), 
+                 &(args_info->backend_orig), &(args_info->backend_given),
+                &(local_args_info.backend_given), optarg, 0, 0, ARG_STRING,
+                check_ambiguity, override, 0, 0,
+                "backend", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* Treat the servers as replicas that all hold every key and pick one for each get: random, roundrobin, least (fewest requests outstanding) or p2c (the less loaded of two random servers).  Sets go to every replica..  */
+          else if (strcmp (long_options[option_index].name, "balance") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->balance_arg), 
+                 &(args_info->balance_orig), &(args_info->balance_given),
+                &(local_args_info.balance_given), optarg, 0, "none", ARG_STRING,
+                check_ambiguity, override, 0, 0,
+                "balance", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* Send sets with noreply and follow every N of them on a connection with a fence (mn).  A set completes when its fence is answered.  The fence, which loading uses too, needs memcached 1.6 or later..  */
+          else if (strcmp (long_options[option_index].name, "noreply") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->noreply_arg), 
+                 &(args_info->noreply_orig), &(args_info->noreply_given),
+                &(local_args_info.noreply_given), optarg, 0, "0", ARG_INT,
+                check_ambiguity, override, 0, 0,
+                "noreply", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* Send a backup copy of a single-key get to another connection or replica once it has been outstanding this long, either a fixed time in microseconds or pNN for the NN-th percentile of get latency seen so far.  The first answer wins..  */
+          else if (strcmp (long_options[option_index].name, "hedge") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->hedge_arg), 
+                 &(args_info->hedge_orig), &(args_info->hedge_given),
+                &(local_args_info.hedge_given), optarg, 0, 0, ARG_STRING,
+                check_ambiguity, override, 0, 0,
+                "hedge", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* Open at most this many connections per second, so that large connection counts do not overrun the servers' accept queues.  0 opens them all at once..  */
+          else if (strcmp (long_options[option_index].name, "ramp") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->ramp_arg), 
+                 &(args_info->ramp_orig), &(args_info->ramp_given),
+                &(local_args_info.ramp_given), optarg, 0, "0", ARG_DOUBLE,
+                check_ambiguity, override, 0, 0,
+                "ramp", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* Fraction of the connections to close and reopen every second.  A connection stops issuing requests and waits for its answers before it reconnects, and with --hash, --fanout or --balance the connections that send requests through it wait with it.  The stay row holds the gets of connections that have not reconnected in the previous second..  */
+          else if (strcmp (long_options[option_index].name, "churn") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->churn_arg), 
+                 &(args_info->churn_orig), &(args_info->churn_given),
+                &(local_args_info.churn_given), optarg, 0, "0", ARG_DOUBLE,
+                check_ambiguity, override, 0, 0,
+                "churn", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* Start every value with its key, a version and a CRC-32C checksum, and check every value read: report values that are corrupt or older than every set answered when a get was sent, except sets that raced with another set of the same key..  */
+          else if (strcmp (long_options[option_index].name, "verify") == 0)
+          {
+          
+          
+            if (update_arg((void *)&(args_info->verify_flag), 0, &(args_info->verify_given),
+                &(local_args_info.verify_given), optarg, 0, 0, ARG_FLAG,
+                check_ambiguity, override, 1, 0, "verify", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* Send gets over UDP.  Sets and loading still use TCP, and gets unanswered after 250ms are counted as lost..  */
+          else if (strcmp (long_options[option_index].name, "udp") == 0)
+          {
+          
+          
+            if (update_arg((void *)&(args_info->udp_flag), 0, &(args_info->udp_given),
+                &(local_args_info.udp_given), optarg, 0, 0, ARG_FLAG,
+                check_ambiguity, override, 1, 0, "udp", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* Connect over TLS.  Certificates are not verified..  */
+          else if (strcmp (long_options[option_index].name, "tls") == 0)
+          {
+          
+          
+            if (update_arg((void *)&(args_info->tls_flag), 0, &(args_info->tls_given),
+                &(local_args_info.tls_given), optarg, 0, 0, ARG_FLAG,
+                check_ambiguity, override, 1, 0, "tls", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* Resume each server's latest TLS session on new connections instead of doing a full handshake..  */
+          else if (strcmp (long_options[option_index].name, "tls-resume") == 0)
+          {
+          
+          
+            if (update_arg((void *)&(args_info->tls_resume_flag), 0, &(args_info->tls_resume_given),
+                &(local_args_info.tls_resume_given), optarg, 0, 0, ARG_FLAG,
+                check_ambiguity, override, 1, 0, "tls-resume", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* Authenticate every connection with USER:PASSWORD using the text protocol's authentication command (memcached -Y)..  */
+          else if (strcmp (long_options[option_index].name, "sasl") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->sasl_arg), 
+                 &(args_info->sasl_orig), &(args_info->sasl_given),
+                &(local_args_info.sasl_given), optarg, 0, 0, ARG_STRING,
+                check_ambiguity, override, 0, 0,
+                "sasl", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* Serve live QPS, hits, misses, bytes and get/set latency histograms in the Prometheus text format at http://127.0.0.1:PORT/metrics while the test runs..  */
+          else if (strcmp (long_options[option_index].name, "metrics") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->metrics_arg), 
+                 &(args_info->metrics_orig), &(args_info->metrics_given),
+                &(local_args_info.metrics_given), optarg, 0, 0, ARG_INT,
+                check_ambiguity, override, 0, 0,
+                "metrics", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* Keep the context of every request slower than this, either a fixed time in microseconds or pNN for the NN-th percentile of its command's latency seen so far: its key, value size, connection, the requests ahead of and behind it on the connection, and when it was sent and answered.  The slowest are printed, with slow requests counted by connection and key..  */
+          else if (strcmp (long_options[option_index].name, "trace-slow") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->trace_slow_arg), 
+                 &(args_info->trace_slow_orig), &(args_info->trace_slow_given),
+                &(local_args_info.trace_slow_given), optarg, 0, 0, ARG_STRING,
+                check_ambiguity, override, 0, 0,
+                "trace-slow", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* Write every request of the measurement to FILE: when it was sent, its latency, type, key, value size, connection and the requests ahead of it, as the binary records of Record.h.  Threads hand them to a writer thread without waiting, and what the writer cannot keep up with is dropped and counted..  */
+          else if (strcmp (long_options[option_index].name, "record") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->record_arg), 
+                 &(args_info->record_orig), &(args_info->record_given),
+                &(local_args_info.record_given), optarg, 0, 0, ARG_STRING,
+                check_ambiguity, override, 0, 0,
+                "record", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* Format of the results: text, json or csv.  json and csv also hold the options given, every latency bucket and --percentiles, for scripts that compare or merge runs, besides the --report intervals, server load and slab classes of the text report..  */
+          else if (strcmp (long_options[option_index].name, "output") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->output_arg), 
+                 &(args_info->output_orig), &(args_info->output_given),
+                &(local_args_info.output_given), optarg, 0, "text", ARG_STRING,
+                check_ambiguity, override, 0, 0,
+                "output", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* Latency percentiles reported by json and csv output..  */
+          else if (strcmp (long_options[option_index].name, "percentiles") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->percentiles_arg), 
+                 &(args_info->percentiles_orig), &(args_info->percentiles_given),
+                &(local_args_info.percentiles_given), optarg, 0, "1,5,10,50,90,95,99,99.9,99.99", ARG_STRING,
+                check_ambiguity, override, 0, 0,
+                "percentiles", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* Skip the database loading phase, e.g. when the servers are already warm..  */
+          else if (strcmp (long_options[option_index].name, "noload") == 0)
+          {
+          
+          
+            if (update_arg((void *)&(args_info->noload_flag), 0, &(args_info->noload_given),
+                &(local_args_info.noload_given), optarg, 0, 0, ARG_FLAG,
+                check_ambiguity, override, 1, 0, "noload", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          
+          break;
         case '?':	/* Invalid option.  */
           /* `getopt_long' already printed an error message.  */
           goto failure;
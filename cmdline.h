@@ -39,23 +39,62 @@ struct gengetopt_args_info
 {
   const char *help_help; /**< @brief Print help and exit help description.  */
   const char *version_help; /**< @brief Print version and exit help description.  */
-  char ** server_arg;	/**< @brief Memcached server hostname[:port].  Repeat to specify multiple servers..  */
-  char ** server_orig;	/**< @brief Memcached server hostname[:port].  Repeat to specify multiple servers. original value given at command line.  */
-  unsigned int server_min; /**< @brief Memcached server hostname[:port].  Repeat to specify multiple servers.'s minimum occurreces */
-  unsigned int server_max; /**< @brief Memcached server hostname[:port].  Repeat to specify multiple servers.'s maximum occurreces */
-  const char *server_help; /**< @brief Memcached server hostname[:port].  Repeat to specify multiple servers. help description.  */
+  char ** server_arg;	/**< @brief Memcached server hostname[:port], or unix:PATH for a UNIX domain socket.  Repeat to specify multiple servers..  */
+  char ** server_orig;	/**< @brief Memcached server hostname[:port], or unix:PATH for a UNIX domain socket.  Repeat to specify multiple servers. original value given at command line.  */
+  unsigned int server_min; /**< @brief Memcached server hostname[:port], or unix:PATH for a UNIX domain socket.  Repeat to specify multiple servers.'s minimum occurreces */
+  unsigned int server_max; /**< @brief Memcached server hostname[:port], or unix:PATH for a UNIX domain socket.  Repeat to specify multiple servers.'s maximum occurreces */
+  const char *server_help; /**< @brief Memcached server hostname[:port], or unix:PATH for a UNIX domain socket.  Repeat to specify multiple servers. help description.  */
   int time_arg;	/**< @brief Maximum time to run (seconds). (default='5').  */
   char * time_orig;	/**< @brief Maximum time to run (seconds). original value given at command line.  */
   const char *time_help; /**< @brief Maximum time to run (seconds). help description.  */
+  long seed_arg;	/**< @brief Seed of the random numbers.  Every connection draws from its own stream of it, so the same seed and options send the same requests.  Defaults to a new seed every run, which is printed..  */
+  char * seed_orig;	/**< @brief Seed of the random numbers.  Every connection draws from its own stream of it, so the same seed and options send the same requests.  Defaults to a new seed every run, which is printed. original value given at command line.  */
+  const char *seed_help; /**< @brief Seed of the random numbers.  Every connection draws from its own stream of it, so the same seed and options send the same requests.  Defaults to a new seed every run, which is printed. help description.  */
   int keysize_arg;	/**< @brief Length of memcached keys. (default='30').  */
   char * keysize_orig;	/**< @brief Length of memcached keys. original value given at command line.  */
   const char *keysize_help; /**< @brief Length of memcached keys. help description.  */
   int valuesize_arg;	/**< @brief Length of memcached values. (default='200').  */
   char * valuesize_orig;	/**< @brief Length of memcached values. original value given at command line.  */
   const char *valuesize_help; /**< @brief Length of memcached values. help description.  */
-  int records_arg;	/**< @brief Number of memcached records to use.  If multiple memcached servers are given, this number is divided by the number of servers. (default='10000').  */
-  char * records_orig;	/**< @brief Number of memcached records to use.  If multiple memcached servers are given, this number is divided by the number of servers. original value given at command line.  */
-  const char *records_help; /**< @brief Number of memcached records to use.  If multiple memcached servers are given, this number is divided by the number of servers. help description.  */
+  int slab_classes_arg;	/**< @brief Spread values over the first N slab classes that can hold a key in a memcached started with --slab-factor and --slab-chunk: each key's value makes its item fill a chunk of its class.  Overrides --valuesize, and latency and throughput are also reported per class. (default='0').  */
+  char * slab_classes_orig;	/**< @brief Spread values over the first N slab classes that can hold a key in a memcached started with --slab-factor and --slab-chunk: each key's value makes its item fill a chunk of its class.  Overrides --valuesize, and latency and throughput are also reported per class. original value given at command line.  */
+  const char *slab_classes_help; /**< @brief Spread values over the first N slab classes that can hold a key in a memcached started with --slab-factor and --slab-chunk: each key's value makes its item fill a chunk of its class.  Overrides --valuesize, and latency and throughput are also reported per class. help description.  */
+  double slab_factor_arg;	/**< @brief Growth factor of the servers' slab classes (memcached -f). (default='1.25').  */
+  char * slab_factor_orig;	/**< @brief Growth factor of the servers' slab classes (memcached -f). original value given at command line.  */
+  const char *slab_factor_help; /**< @brief Growth factor of the servers' slab classes (memcached -f). help description.  */
+  int slab_chunk_arg;	/**< @brief Minimum space for key, value and flags in the smallest slab class (memcached -n). (default='48').  */
+  char * slab_chunk_orig;	/**< @brief Minimum space for key, value and flags in the smallest slab class (memcached -n). original value given at command line.  */
+  const char *slab_chunk_help; /**< @brief Minimum space for key, value and flags in the smallest slab class (memcached -n). help description.  */
+  int records_arg;	/**< @brief Number of memcached records to use.  If multiple memcached servers are given and --hash is none, this number is divided by the number of servers. (default='10000').  */
+  char * records_orig;	/**< @brief Number of memcached records to use.  If multiple memcached servers are given and --hash is none, this number is divided by the number of servers. original value given at command line.  */
+  const char *records_help; /**< @brief Number of memcached records to use.  If multiple memcached servers are given and --hash is none, this number is divided by the number of servers. help description.  */
+  int keyspace_arg;	/**< @brief Number of keys gets are drawn from.  Keys beyond --records are never loaded, so they miss until something sets them.  Divided like --records.  Defaults to --records, or twice that with --hit-ratio. (default='0').  */
+  char * keyspace_orig;	/**< @brief Number of keys gets are drawn from.  Keys beyond --records are never loaded, so they miss until something sets them.  Divided like --records.  Defaults to --records, or twice that with --hit-ratio. original value given at command line.  */
+  const char *keyspace_help; /**< @brief Number of keys gets are drawn from.  Keys beyond --records are never loaded, so they miss until something sets them.  Divided like --records.  Defaults to --records, or twice that with --hit-ratio. help description.  */
+  double hit_ratio_arg;	/**< @brief Fraction of gets that ask for a loaded key; the others ask for a key between --records and --keyspace..  */
+  char * hit_ratio_orig;	/**< @brief Fraction of gets that ask for a loaded key; the others ask for a key between --records and --keyspace. original value given at command line.  */
+  const char *hit_ratio_help; /**< @brief Fraction of gets that ask for a loaded key; the others ask for a key between --records and --keyspace. help description.  */
+  double zipf_arg;	/**< @brief Draw the keys of gets, sets and other commands from --keyspace with Zipf popularity of this exponent instead of uniformly, so that the hot set is also the one rewritten. (default='0').  */
+  char * zipf_orig;	/**< @brief Draw the keys of gets, sets and other commands from --keyspace with Zipf popularity of this exponent instead of uniformly, so that the hot set is also the one rewritten. original value given at command line.  */
+  const char *zipf_help; /**< @brief Draw the keys of gets, sets and other commands from --keyspace with Zipf popularity of this exponent instead of uniformly, so that the hot set is also the one rewritten. help description.  */
+  double hot_drift_arg;	/**< @brief Rotate the Zipf ranks by this many keys per second, so the hot set slides through the keyspace. (default='0').  */
+  char * hot_drift_orig;	/**< @brief Rotate the Zipf ranks by this many keys per second, so the hot set slides through the keyspace. original value given at command line.  */
+  const char *hot_drift_help; /**< @brief Rotate the Zipf ranks by this many keys per second, so the hot set slides through the keyspace. help description.  */
+  double hot_jump_arg;	/**< @brief Move the Zipf hot set to a new random place in the keyspace every this many seconds. (default='0').  */
+  char * hot_jump_orig;	/**< @brief Move the Zipf hot set to a new random place in the keyspace every this many seconds. original value given at command line.  */
+  const char *hot_jump_help; /**< @brief Move the Zipf hot set to a new random place in the keyspace every this many seconds. help description.  */
+  char * ttl_arg;	/**< @brief Expiration time in seconds of every set, as a distribution like --backend.  0 never expires, and times are capped at memcached's 30 days..  */
+  char * ttl_orig;	/**< @brief Expiration time in seconds of every set, as a distribution like --backend.  0 never expires, and times are capped at memcached's 30 days. original value given at command line.  */
+  const char *ttl_help; /**< @brief Expiration time in seconds of every set, as a distribution like --backend.  0 never expires, and times are capped at memcached's 30 days. help description.  */
+  double expire_storm_arg;	/**< @brief Make a fraction of the loaded records expire together this many seconds after startup, connecting and loading included.  Use with --report to follow misses and refills around that moment. (default='0').  */
+  char * expire_storm_orig;	/**< @brief Make a fraction of the loaded records expire together this many seconds after startup, connecting and loading included.  Use with --report to follow misses and refills around that moment. original value given at command line.  */
+  const char *expire_storm_help; /**< @brief Make a fraction of the loaded records expire together this many seconds after startup, connecting and loading included.  Use with --report to follow misses and refills around that moment. help description.  */
+  double expire_fraction_arg;	/**< @brief Fraction of the loaded records that expire in the --expire-storm. (default='1').  */
+  char * expire_fraction_orig;	/**< @brief Fraction of the loaded records that expire in the --expire-storm. original value given at command line.  */
+  const char *expire_fraction_help; /**< @brief Fraction of the loaded records that expire in the --expire-storm. help description.  */
+  double report_arg;	/**< @brief Also print throughput, hit ratio and read latency for every interval of this many seconds, e.g. to watch evictions when the records do not fit in the servers' memory. (default='0').  */
+  char * report_orig;	/**< @brief Also print throughput, hit ratio and read latency for every interval of this many seconds, e.g. to watch evictions when the records do not fit in the servers' memory. original value given at command line.  */
+  const char *report_help; /**< @brief Also print throughput, hit ratio and read latency for every interval of this many seconds, e.g. to watch evictions when the records do not fit in the servers' memory. help description.  */
   float ratio_arg;	/**< @brief Ratio of set/get commands. (default='0.0').  */
   char * ratio_orig;	/**< @brief Ratio of set/get commands. original value given at command line.  */
   const char *ratio_help; /**< @brief Ratio of set/get commands. help description.  */
@@ -65,17 +104,113 @@ struct gengetopt_args_info
   int depth_arg;	/**< @brief Maximum depth to pipeline requests. (default='1').  */
   char * depth_orig;	/**< @brief Maximum depth to pipeline requests. original value given at command line.  */
   const char *depth_help; /**< @brief Maximum depth to pipeline requests. help description.  */
+  char * hash_arg;	/**< @brief How keys are distributed across servers: none (every connection uses its own server's keys), ketama (the MD5 continuum of libketama, for equally weighted servers) or jump. (default='none').  */
+  char * hash_orig;	/**< @brief How keys are distributed across servers: none (every connection uses its own server's keys), ketama (the MD5 continuum of libketama, for equally weighted servers) or jump. original value given at command line.  */
+  const char *hash_help; /**< @brief How keys are distributed across servers: none (every connection uses its own server's keys), ketama (the MD5 continuum of libketama, for equally weighted servers) or jump. help description.  */
+  char * mix_arg;	/**< @brief Weighted command mix, e.g. get=80,set=10,delete=2,incr=2,decr=1,touch=1,append=1,prepend=1,gets=1,cas=1. Overrides --ratio.  incr and decr use counter keys loaded with 0, and cas is a gets followed by a cas, retried on conflict..  */
+  char * mix_orig;	/**< @brief Weighted command mix, e.g. get=80,set=10,delete=2,incr=2,decr=1,touch=1,append=1,prepend=1,gets=1,cas=1. Overrides --ratio.  incr and decr use counter keys loaded with 0, and cas is a gets followed by a cas, retried on conflict. original value given at command line.  */
+  const char *mix_help; /**< @brief Weighted command mix, e.g. get=80,set=10,delete=2,incr=2,decr=1,touch=1,append=1,prepend=1,gets=1,cas=1. Overrides --ratio.  incr and decr use counter keys loaded with 0, and cas is a gets followed by a cas, retried on conflict. help description.  */
+  char * backend_arg;	/**< @brief Cache-aside mode: a single-key get that misses waits for a backend fetch taking this many microseconds, then sets the key.  The whole access counts as one get, and the miss row shows the fetch and the set alone.  A number or fixed:X, uniform:MAX, normal:MEAN,SD, exponential:MEAN or pareto:LOC,SCALE,SHAPE..  */
+  char * backend_orig;	/**< @brief Cache-aside mode: a single-key get that misses waits for a backend fetch taking this many microseconds, then sets the key.  The whole access counts as one get, and the miss row shows the fetch and the set alone.  A number or fixed:X, uniform:MAX, normal:MEAN,SD, exponential:MEAN or pareto:LOC,SCALE,SHAPE. original value given at command line.  */
+  const char *backend_help; /**< @brief Cache-aside mode: a single-key get that misses waits for a backend fetch taking this many microseconds, then sets the key.  The whole access counts as one get, and the miss row shows the fetch and the set alone.  A number or fixed:X, uniform:MAX, normal:MEAN,SD, exponential:MEAN or pareto:LOC,SCALE,SHAPE. help description.  */
+  int multiget_arg;	/**< @brief Number of keys fetched by each get.  Keys owned by different servers are fetched in parallel. (default='1').  */
+  char * multiget_orig;	/**< @brief Number of keys fetched by each get.  Keys owned by different servers are fetched in parallel. original value given at command line.  */
+  const char *multiget_help; /**< @brief Number of keys fetched by each get.  Keys owned by different servers are fetched in parallel. help description.  */
+  int fanout_arg;	/**< @brief Number of distinct servers each get fans out to.  The get completes when the slowest server has answered. (default='1').  */
+  char * fanout_orig;	/**< @brief Number of distinct servers each get fans out to.  The get completes when the slowest server has answered. original value given at command line.  */
+  const char *fanout_help; /**< @brief Number of distinct servers each get fans out to.  The get completes when the slowest server has answered. help description.  */
+  char * balance_arg;	/**< @brief Treat the servers as replicas that all hold every key and pick one for each get: random, roundrobin, least (fewest requests outstanding) or p2c (the less loaded of two random servers).  Sets go to every replica. (default='none').  */
+  char * balance_orig;	/**< @brief Treat the servers as replicas that all hold every key and pick one for each get: random, roundrobin, least (fewest requests outstanding) or p2c (the less loaded of two random servers).  Sets go to every replica. original value given at command line.  */
+  const char *balance_help; /**< @brief Treat the servers as replicas that all hold every key and pick one for each get: random, roundrobin, least (fewest requests outstanding) or p2c (the less loaded of two random servers).  Sets go to every replica. help description.  */
+  int noreply_arg;	/**< @brief Send sets with noreply and follow every N of them on a connection with a fence (mn).  A set completes when its fence is answered.  The fence, which loading uses too, needs memcached 1.6 or later. (default='0').  */
+  char * noreply_orig;	/**< @brief Send sets with noreply and follow every N of them on a connection with a fence (mn).  A set completes when its fence is answered.  The fence, which loading uses too, needs memcached 1.6 or later. original value given at command line.  */
+  const char *noreply_help; /**< @brief Send sets with noreply and follow every N of them on a connection with a fence (mn).  A set completes when its fence is answered.  The fence, which loading uses too, needs memcached 1.6 or later. help description.  */
+  char * hedge_arg;	/**< @brief Send a backup copy of a single-key get to another connection or replica once it has been outstanding this long, either a fixed time in microseconds or pNN for the NN-th percentile of get latency seen so far.  The first answer wins..  */
+  char * hedge_orig;	/**< @brief Send a backup copy of a single-key get to another connection or replica once it has been outstanding this long, either a fixed time in microseconds or pNN for the NN-th percentile of get latency seen so far.  The first answer wins. original value given at command line.  */
+  const char *hedge_help; /**< @brief Send a backup copy of a single-key get to another connection or replica once it has been outstanding this long, either a fixed time in microseconds or pNN for the NN-th percentile of get latency seen so far.  The first answer wins. help description.  */
+  int threads_arg;	/**< @brief Number of threads to spawn.  Connections to each server are spread across the threads. (default='1').  */
+  char * threads_orig;	/**< @brief Number of threads to spawn.  Connections to each server are spread across the threads. original value given at command line.  */
+  const char *threads_help; /**< @brief Number of threads to spawn.  Connections to each server are spread across the threads. help description.  */
+  double ramp_arg;	/**< @brief Open at most this many connections per second, so that large connection counts do not overrun the servers' accept queues.  0 opens them all at once. (default='0').  */
+  char * ramp_orig;	/**< @brief Open at most this many connections per second, so that large connection counts do not overrun the servers' accept queues.  0 opens them all at once. original value given at command line.  */
+  const char *ramp_help; /**< @brief Open at most this many connections per second, so that large connection counts do not overrun the servers' accept queues.  0 opens them all at once. help description.  */
+  double churn_arg;	/**< @brief Fraction of the connections to close and reopen every second.  A connection stops issuing requests and waits for its answers before it reconnects, and with --hash, --fanout or --balance the connections that send requests through it wait with it.  The stay row holds the gets of connections that have not reconnected in the previous second. (default='0').  */
+  char * churn_orig;	/**< @brief Fraction of the connections to close and reopen every second.  A connection stops issuing requests and waits for its answers before it reconnects, and with --hash, --fanout or --balance the connections that send requests through it wait with it.  The stay row holds the gets of connections that have not reconnected in the previous second. original value given at command line.  */
+  const char *churn_help; /**< @brief Fraction of the connections to close and reopen every second.  A connection stops issuing requests and waits for its answers before it reconnects, and with --hash, --fanout or --balance the connections that send requests through it wait with it.  The stay row holds the gets of connections that have not reconnected in the previous second. help description.  */
+  int verify_flag;	/**< @brief Start every value with its key, a version and a CRC-32C checksum, and check every value read: report values that are corrupt or older than every set answered when a get was sent, except sets that raced with another set of the same key. (default=off).  */
+  const char *verify_help; /**< @brief Start every value with its key, a version and a CRC-32C checksum, and check every value read: report values that are corrupt or older than every set answered when a get was sent, except sets that raced with another set of the same key. help description.  */
+  int udp_flag;	/**< @brief Send gets over UDP.  Sets and loading still use TCP, and gets unanswered after 250ms are counted as lost. (default=off).  */
+  const char *udp_help; /**< @brief Send gets over UDP.  Sets and loading still use TCP, and gets unanswered after 250ms are counted as lost. help description.  */
+  int tls_flag;	/**< @brief Connect over TLS.  Certificates are not verified. (default=off).  */
+  const char *tls_help; /**< @brief Connect over TLS.  Certificates are not verified. help description.  */
+  int tls_resume_flag;	/**< @brief Resume each server's latest TLS session on new connections instead of doing a full handshake. (default=off).  */
+  const char *tls_resume_help; /**< @brief Resume each server's latest TLS session on new connections instead of doing a full handshake. help description.  */
+  char * sasl_arg;	/**< @brief Authenticate every connection with USER:PASSWORD using the text protocol's authentication command (memcached -Y)..  */
+  char * sasl_orig;	/**< @brief Authenticate every connection with USER:PASSWORD using the text protocol's authentication command (memcached -Y). original value given at command line.  */
+  const char *sasl_help; /**< @brief Authenticate every connection with USER:PASSWORD using the text protocol's authentication command (memcached -Y). help description.  */
+  int metrics_arg;	/**< @brief Serve live QPS, hits, misses, bytes and get/set latency histograms in the Prometheus text format at http://127.0.0.1:PORT/metrics while the test runs..  */
+  char * metrics_orig;	/**< @brief Serve live QPS, hits, misses, bytes and get/set latency histograms in the Prometheus text format at http://127.0.0.1:PORT/metrics while the test runs. original value given at command line.  */
+  const char *metrics_help; /**< @brief Serve live QPS, hits, misses, bytes and get/set latency histograms in the Prometheus text format at http://127.0.0.1:PORT/metrics while the test runs. help description.  */
+  char * trace_slow_arg;	/**< @brief Keep the context of every request slower than this, either a fixed time in microseconds or pNN for the NN-th percentile of its command's latency seen so far: its key, value size, connection, the requests ahead of and behind it on the connection, and when it was sent and answered.  The slowest are printed, with slow requests counted by connection and key..  */
+  char * trace_slow_orig;	/**< @brief Keep the context of every request slower than this, either a fixed time in microseconds or pNN for the NN-th percentile of its command's latency seen so far: its key, value size, connection, the requests ahead of and behind it on the connection, and when it was sent and answered.  The slowest are printed, with slow requests counted by connection and key. original value given at command line.  */
+  const char *trace_slow_help; /**< @brief Keep the context of every request slower than this, either a fixed time in microseconds or pNN for the NN-th percentile of its command's latency seen so far: its key, value size, connection, the requests ahead of and behind it on the connection, and when it was sent and answered.  The slowest are printed, with slow requests counted by connection and key. help description.  */
+  char * record_arg;	/**< @brief Write every request of the measurement to FILE: when it was sent, its latency, type, key, value size, connection and the requests ahead of it, as the binary records of Record.h.  Threads hand them to a writer thread without waiting, and what the writer cannot keep up with is dropped and counted..  */
+  char * record_orig;	/**< @brief Write every request of the measurement to FILE: when it was sent, its latency, type, key, value size, connection and the requests ahead of it, as the binary records of Record.h.  Threads hand them to a writer thread without waiting, and what the writer cannot keep up with is dropped and counted. original value given at command line.  */
+  const char *record_help; /**< @brief Write every request of the measurement to FILE: when it was sent, its latency, type, key, value size, connection and the requests ahead of it, as the binary records of Record.h.  Threads hand them to a writer thread without waiting, and what the writer cannot keep up with is dropped and counted. help description.  */
+  char * output_arg;	/**< @brief Format of the results: text, json or csv.  json and csv also hold the options given, every latency bucket and --percentiles, for scripts that compare or merge runs, besides the --report intervals, server load and slab classes of the text report. (default='text').  */
+  char * output_orig;	/**< @brief Format of the results: text, json or csv.  json and csv also hold the options given, every latency bucket and --percentiles, for scripts that compare or merge runs, besides the --report intervals, server load and slab classes of the text report. original value given at command line.  */
+  const char *output_help; /**< @brief Format of the results: text, json or csv.  json and csv also hold the options given, every latency bucket and --percentiles, for scripts that compare or merge runs, besides the --report intervals, server load and slab classes of the text report. help description.  */
+  char * percentiles_arg;	/**< @brief Latency percentiles reported by json and csv output. (default='1,5,10,50,90,95,99,99.9,99.99').  */
+  char * percentiles_orig;	/**< @brief Latency percentiles reported by json and csv output. original value given at command line.  */
+  const char *percentiles_help; /**< @brief Latency percentiles reported by json and csv output. help description.  */
+  int noload_flag;	/**< @brief Skip the database loading phase, e.g. when the servers are already warm. (default=off).  */
+  const char *noload_help; /**< @brief Skip the database loading phase, e.g. when the servers are already warm. help description.  */
   
   unsigned int help_given ;	/**< @brief Whether help was given.  */
   unsigned int version_given ;	/**< @brief Whether version was given.  */
   unsigned int server_given ;	/**< @brief Whether server was given.  */
   unsigned int time_given ;	/**< @brief Whether time was given.  */
+  unsigned int seed_given ;	/**< @brief Whether seed was given.  */
   unsigned int keysize_given ;	/**< @brief Whether keysize was given.  */
   unsigned int valuesize_given ;	/**< @brief Whether valuesize was given.  */
+  unsigned int slab_classes_given ;	/**< @brief Whether slab-classes was given.  */
+  unsigned int slab_factor_given ;	/**< @brief Whether slab-factor was given.  */
+  unsigned int slab_chunk_given ;	/**< @brief Whether slab-chunk was given.  */
   unsigned int records_given ;	/**< @brief Whether records was given.  */
+  unsigned int keyspace_given ;	/**< @brief Whether keyspace was given.  */
+  unsigned int hit_ratio_given ;	/**< @brief Whether hit-ratio was given.  */
+  unsigned int zipf_given ;	/**< @brief Whether zipf was given.  */
+  unsigned int hot_drift_given ;	/**< @brief Whether hot-drift was given.  */
+  unsigned int hot_jump_given ;	/**< @brief Whether hot-jump was given.  */
+  unsigned int ttl_given ;	/**< @brief Whether ttl was given.  */
+  unsigned int expire_storm_given ;	/**< @brief Whether expire-storm was given.  */
+  unsigned int expire_fraction_given ;	/**< @brief Whether expire-fraction was given.  */
+  unsigned int report_given ;	/**< @brief Whether report was given.  */
   unsigned int ratio_given ;	/**< @brief Whether ratio was given.  */
   unsigned int connections_given ;	/**< @brief Whether connections was given.  */
   unsigned int depth_given ;	/**< @brief Whether depth was given.  */
+  unsigned int hash_given ;	/**< @brief Whether hash was given.  */
+  unsigned int mix_given ;	/**< @brief Whether mix was given.  */
+  unsigned int backend_given ;	/**< @brief Whether backend was given.  */
+  unsigned int multiget_given ;	/**< @brief Whether multiget was given.  */
+  unsigned int fanout_given ;	/**< @brief Whether fanout was given.  */
+  unsigned int balance_given ;	/**< @brief Whether balance was given.  */
+  unsigned int noreply_given ;	/**< @brief Whether noreply was given.  */
+  unsigned int hedge_given ;	/**< @brief Whether hedge was given.  */
+  unsigned int threads_given ;	/**< @brief Whether threads was given.  */
+  unsigned int ramp_given ;	/**< @brief Whether ramp was given.  */
+  unsigned int churn_given ;	/**< @brief Whether churn was given.  */
+  unsigned int verify_given ;	/**< @brief Whether verify was given.  */
+  unsigned int udp_given ;	/**< @brief Whether udp was given.  */
+  unsigned int tls_given ;	/**< @brief Whether tls was given.  */
+  unsigned int tls_resume_given ;	/**< @brief Whether tls-resume was given.  */
+  unsigned int sasl_given ;	/**< @brief Whether sasl was given.  */
+  unsigned int metrics_given ;	/**< @brief Whether metrics was given.  */
+  unsigned int trace_slow_given ;	/**< @brief Whether trace-slow was given.  */
+  unsigned int record_given ;	/**< @brief Whether record was given.  */
+  unsigned int output_given ;	/**< @brief Whether output was given.  */
+  unsigned int percentiles_given ;	/**< @brief Whether percentiles was given.  */
+  unsigned int noload_given ;	/**< @brief Whether noload was given.  */
 
 } ;
 
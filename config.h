@@ -4,8 +4,34 @@
 #include "cmdline.h"
 
 #define MINIMUM_KEY_LENGTH 2
-#define MAXIMUM_CONNECTIONS 512
+#define MAXIMUM_CONNECTIONS 1048576
+#define RESERVED_FDS 64
 #define LOADER_CHUNK 1024
+#define LOADER_DEPTH 8
+#define FANOUT_KEY_TRIES 1000
+#define HEDGE_UPDATE 1000
+#define CONCAT_LENGTH 8
+#define UDP_BATCH 64
+#define UDP_DATAGRAM 1400
+#define UDP_BUFFER 2048
+#define UDP_TIMEOUT 0.25
+#define RANDOM_CHAR_SIZE (2 * 1024 * 1024)
+#define VALUE_REFERENCE (16 * 1024)
+#define METRICS_PUBLISH 0.25
+#define CHURN_SETTLE 1.0
+#define MAXIMUM_TTL (30 * 24 * 3600)
+#define RECORD_RING (64 * 1024)
+#define RECORD_DRAIN 0.001
+#define TRACE_AHEAD 8
+#define TRACE_SLOWEST 100
+#define TRACE_PRINT 20
+
+// memcached's item header, the cas stored after it, chunk alignment, and
+// the largest chunk before items are split across chunks.
+#define SLAB_ITEM_HEADER 48
+#define SLAB_CAS 8
+#define SLAB_ALIGN 8
+#define SLAB_CHUNK_MAX (512 * 1024)
 
 extern char random_char[];
 extern gengetopt_args_info args;
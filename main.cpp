@@ -1,9 +1,16 @@
 #include <arpa/inet.h>
+#include <pthread.h>
+#include <sys/resource.h>
+#include <sys/un.h>
 
+#include <math.h>
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <unistd.h>
 
+#include <algorithm>
+#include <map>
 #include <vector>
 #include <iostream>
 
@@ -12,11 +19,35 @@
 
 #include "util.h"
 #include "Connection.h"
+#include "KeyRouter.h"
+#include "Metrics.h"
+#include "Output.h"
+#include "Random.h"
+#include "Record.h"
+#include "TLS.h"
+#include "Verify.h"
 #include "config.h"
 #include "cmdline.h"
 
-char random_char[2 * 1024 * 1024];
+char random_char[RANDOM_CHAR_SIZE];
 gengetopt_args_info args;
+pthread_barrier_t barrier;
+
+struct thread_data {
+  const vector<pair<string, int>> *servers;
+  options_t *options;
+  KeyRouter *router;
+  int id;
+};
+
+// A connection's churn schedule, from a stream of its own so that it does
+// not depend on --threads or on the connection's requests.
+struct churn_data {
+  Connection *conn;
+  Random rng;
+  double rate;
+  struct event *timer;
+};
 
 void init_random_char() {
   char init_char[] = "The libevent API provides a mechanism to execute a callback function when a specific event occurs on a file descriptor or after a timeout has been reached. Furthermore, libevent also support callbacks due to signals or regular timeouts. libevent is meant to replace the event loop found in event driven network servers. An application just needs to call event_dispatch() and then add or remove events dynamically without having to change the event loop.";
@@ -35,14 +66,166 @@ void args_to_options(options_t* options) {
   options->time = args.time_arg;
   options->keysize = args.keysize_arg;
   options->valuesize = args.valuesize_arg;
-  options->records = args.records_arg / args.server_given;
+
+  // The slab classes as memcached's slabs_init() builds them: aligned chunk
+  // sizes grow by the factor until one reaches the largest chunk over the
+  // factor, and a last class holds the largest chunk.
+  vector<int> chunks(1, 0);
+  unsigned int size = SLAB_ITEM_HEADER + args.slab_chunk_arg;
+  while (chunks.size() < MAX_SLAB_CLASSES &&
+         size < SLAB_CHUNK_MAX / args.slab_factor_arg) {
+    if (size % SLAB_ALIGN) size += SLAB_ALIGN - size % SLAB_ALIGN;
+    chunks.push_back(size);
+    size *= args.slab_factor_arg;
+  }
+  chunks.push_back(SLAB_CHUNK_MAX);
+
+  options->slab_classes = 0;
+  for (int id = 1; id < (int) chunks.size() &&
+         options->slab_classes < args.slab_classes_arg; id++) {
+    int value = chunks[id] - SLAB_ITEM_HEADER - SLAB_CAS -
+      (args.keysize_arg + 1) - 2;
+    if (value >= (args.verify_flag ? (int) sizeof(verify_header_t) : 1)) {
+      options->slab_id[options->slab_classes] = id;
+      options->slab_chunk[options->slab_classes] = chunks[id];
+      options->slab_value[options->slab_classes++] = value;
+    }
+  }
+  if (options->slab_classes < args.slab_classes_arg)
+    die("--slab-classes is more than the servers have for this --keysize");
+  options->records = args.records_arg;
+  if (!strcmp(args.hash_arg, "none") && !strcmp(args.balance_arg, "none"))
+    options->records /= args.server_given;
   if (!options->records) options->records = 1;
+
+  options->keyspace = args.keyspace_arg;
+  if (args.keyspace_given &&
+      !strcmp(args.hash_arg, "none") && !strcmp(args.balance_arg, "none"))
+    options->keyspace /= args.server_given;
+  if (!args.keyspace_given)
+    options->keyspace = options->records * (args.hit_ratio_given ? 2 : 1);
+  if (options->keyspace < options->records) options->keyspace = options->records;
+
+  options->hit_ratio = args.hit_ratio_given ? args.hit_ratio_arg : -1.0;
+  options->report = args.report_arg;
+
+  options->ttl = args.ttl_given;
+  if (args.ttl_given) {
+    if (strlen(args.ttl_arg) >= sizeof(options->ttl_dist))
+      die("--ttl is too long");
+    strcpy(options->ttl_dist, args.ttl_arg);
+  }
+  // Storm records all get this second as their absolute expiry time.
+  options->storm_at = args.expire_storm_given ?
+    ceil(get_time() + args.expire_storm_arg) : 0.0;
+  options->storm_fraction = args.expire_fraction_arg;
+  options->zipf = args.zipf_arg;
+  options->hot_drift = args.hot_drift_arg;
+  options->hot_jump = args.hot_jump_arg;
   options->ratio = args.ratio_arg;
   options->connections = args.connections_arg;
   options->depth = args.depth_arg;
+  options->multiget = args.multiget_arg;
+  options->fanout = args.fanout_arg;
+  options->noreply = args.noreply_arg;
+
+  options->cache_aside = args.backend_given;
+  if (args.backend_given) {
+    if (strlen(args.backend_arg) >= sizeof(options->backend))
+      die("--backend is too long");
+    strcpy(options->backend, args.backend_arg);
+  }
+
+  options->mix = args.mix_given;
+  options->counters = false;
+  if (args.mix_given) {
+    double weights[Operation::COMMANDS] = {0.0};
+    double sum = 0.0;
+    char *copy = strdup(args.mix_arg), *save_ptr = NULL;
+
+    for (char *p = strtok_r(copy, ",", &save_ptr); p;
+         p = strtok_r(NULL, ",", &save_ptr)) {
+      char *eq = strchr(p, '=');
+      int type = 0;
+      if (eq) *eq = '\0';
+      while (type < Operation::COMMANDS && strcmp(p, Operation::name(type)))
+        type++;
+      if (eq == NULL || type == Operation::COMMANDS || atof(eq + 1) < 0.0)
+        die("--mix must be a list of command=weight");
+      weights[type] += atof(eq + 1);
+      sum += atof(eq + 1);
+    }
+    free(copy);
+
+    if (sum <= 0.0) die("--mix needs a positive weight");
+    for (int i = 0; i < Operation::COMMANDS; i++)
+      options->mix_cdf[i] = (i ? options->mix_cdf[i - 1] : 0.0) +
+        weights[i] / sum;
+    options->counters =
+      weights[Operation::INCR] > 0.0 || weights[Operation::DECR] > 0.0;
+  }
+
+  if (!strcmp(args.balance_arg, "none"))
+    options->balance = BALANCE_NONE;
+  else if (!strcmp(args.balance_arg, "random"))
+    options->balance = BALANCE_RANDOM;
+  else if (!strcmp(args.balance_arg, "roundrobin"))
+    options->balance = BALANCE_ROUNDROBIN;
+  else if (!strcmp(args.balance_arg, "least"))
+    options->balance = BALANCE_LEAST;
+  else if (!strcmp(args.balance_arg, "p2c"))
+    options->balance = BALANCE_P2C;
+  else
+    die("--balance must be one of none, random, roundrobin, least or p2c");
+
+  options->hedge = args.hedge_given;
+  options->hedge_after = 0.0;
+  options->hedge_percentile = 0.0;
+  if (args.hedge_given) {
+    if (args.hedge_arg[0] == 'p')
+      options->hedge_percentile = atof(args.hedge_arg + 1);
+    else
+      options->hedge_after = atof(args.hedge_arg);
+  }
+  options->trace = args.trace_slow_given;
+  options->trace_after = 0.0;
+  options->trace_percentile = 0.0;
+  if (args.trace_slow_given) {
+    if (args.trace_slow_arg[0] == 'p')
+      options->trace_percentile = atof(args.trace_slow_arg + 1);
+    else
+      options->trace_after = atof(args.trace_slow_arg);
+  }
+  options->threads = args.threads_arg;
+
+  // Without --seed every run differs; the seed is printed to repeat it.
+  options->seed = args.seed_given ? (uint64_t) args.seed_arg :
+    (uint64_t) (get_time() * 1000000) ^ ((uint64_t) getpid() << 32);
+  options->ramp = args.ramp_arg;
+  options->churn = args.churn_arg;
+  options->noload = args.noload_flag;
+
+  options->verify = args.verify_flag;
+  options->udp = args.udp_flag;
+  options->tls = args.tls_flag;
+  options->sasl = args.sasl_given;
+  if (args.sasl_given) {
+    const char *colon = strchr(args.sasl_arg, ':');
+    if (colon == NULL || colon - args.sasl_arg >= 32 || strlen(colon) > 32)
+      die("--sasl must be USER:PASSWORD, each at most 31 characters");
+    snprintf(options->username, colon - args.sasl_arg + 1, "%s", args.sasl_arg);
+    snprintf(options->password, 32, "%s", colon + 1);
+  }
 }
 
 pair<string, int> string_to_addr(string host) {
+  // UNIX domain sockets keep their prefix, which Connection looks for.
+  if (!host.compare(0, 5, "unix:")) {
+    if (host.length() - 5 >= sizeof(((struct sockaddr_un *) 0)->sun_path))
+      die("UNIX socket path is too long");
+    return {host, 0};
+  }
+
   char *s_copy = new char[host.length() + 1];
   strcpy(s_copy, host.c_str());
 
@@ -83,56 +266,463 @@ pair<string, int> string_to_addr(string host) {
   return server;
 }
 
+// Connections only become ready while waiting, so the scan resumes from
+// the first one that was not ready last time.
 void wait_until_idle(struct event_base* base, vector<Connection*> & connections) {
+  size_t ready = 0;
+
   while (1) {
+    while (ready < connections.size() && connections[ready]->is_ready())
+      ready++;
+    if (ready == connections.size()) break;
+
     event_base_loop(base, EVLOOP_ONCE);
+  }
+}
 
-    bool restart = false;
-    for (Connection *conn: connections)
-      if (!conn->is_ready()) restart = true;
+// Open the connections, at most rate per second when rate > 0.
+void open_connections(struct event_base* base,
+                      vector<Connection*> & connections, double rate) {
+  double start = get_time();
 
-    if (restart) continue;
-    else break;
+  for (size_t i = 0; i < connections.size(); i++) {
+    if (rate > 0.0) {
+      double delay = start + i / rate - get_time();
+      if (delay > 0.0) {
+        struct timeval tv;
+        double_to_tv(delay, &tv);
+        event_base_loopexit(base, &tv);
+        event_base_dispatch(base);
+      }
+    }
+
+    connections[i]->connect();
+  }
+}
+
+// Every connection churns at exponential intervals of mean 1 / --churn.
+void churn_schedule(churn_data* churn) {
+  struct timeval tv;
+  double_to_tv(-log(1 - churn->rng.uniform()) / churn->rate, &tv);
+  evtimer_add(churn->timer, &tv);
+}
+
+void churn_cb(evutil_socket_t fd, short what, void *ptr) {
+  churn_data *churn = (churn_data *) ptr;
+  churn->conn->churn();
+  churn_schedule(churn);
+}
+
+// --percentiles, e.g. "99,99.9,99.99".
+vector<double> parse_percentiles(const char* list) {
+  vector<double> percentiles;
+  const char *p = list;
+
+  while (*p) {
+    char *end;
+    double nth = strtod(p, &end);
+    if (end == p || nth < 0.0 || nth > 100.0 || (*end && *end != ','))
+      die("--percentiles must be a list of numbers between [0,100]");
+    percentiles.push_back(nth);
+    p = *end ? end + 1 : end;
+  }
+
+  return percentiles;
+}
+
+// The options given, as cmdline_parser_dump() writes them, with the seed
+// actually used.
+void print_config(Output* output, options_t& options) {
+  char *dump = NULL;
+  size_t size = 0;
+  FILE *f;
+  DIE_Z(f = open_memstream(&dump, &size));
+  cmdline_parser_dump(f, &args);
+  fclose(f);
+
+  vector<string> servers;
+  char *save, *line = strtok_r(dump, "\n", &save);
+  for (; line; line = strtok_r(NULL, "\n", &save)) {
+    char *eq = strchr(line, '=');
+    string value = "true";
+    if (eq) {
+      *eq = '\0';
+      value = string(eq + 2, strlen(eq + 2) - 1);
+    }
+
+    if (!strcmp(line, "server")) servers.push_back(value);
+    else if (strcmp(line, "seed")) output->value(line, value);
+  }
+  free(dump);
+
+  output->list("server", servers);
+  output->value("seed", to_string(options.seed));
+}
+
+void print_output(Output* output, ConnectionStats& stats, options_t& options,
+                  const vector<double>& percentiles) {
+  double elapsed = stats.stop - stats.start;
+  uint64_t total = stats.gets + stats.sets;
+  for (int i = 0; i < Operation::COMMANDS; i++) total += stats.cmd_ops[i];
+
+  output->begin();
+
+  output->section("config");
+  print_config(output, options);
+
+  output->section("summary");
+  output->value("elapsed", elapsed);
+  output->value("qps", total / elapsed);
+  output->value("requests", total);
+  output->value("gets", stats.gets);
+  output->value("sets", stats.sets);
+  output->value("get_keys", stats.get_keys);
+  output->value("get_misses", stats.get_misses);
+  output->value("skips", stats.skips);
+  for (int i = Operation::SET + 1; i < Operation::COMMANDS; i++) {
+    if (stats.cmd_ops[i] == 0) continue;
+    string name = Operation::name(i);
+    output->value((name + "_ops").c_str(), stats.cmd_ops[i]);
+    output->value((name + "_not_found").c_str(), stats.cmd_misses[i]);
+  }
+  if (stats.cmd_ops[Operation::CAS])
+    output->value("cas_retries", stats.cas_retries);
+  if (options.cache_aside) output->value("refills", stats.refills);
+  if (options.hedge) {
+    output->value("hedges", stats.hedges);
+    output->value("hedge_wins", stats.hedge_wins);
+  }
+  if (options.noreply) output->value("fences", stats.fences);
+  if (options.verify) {
+    output->value("verified", stats.verified);
+    output->value("corrupt", stats.corrupt);
+    output->value("stale", stats.stale);
+  }
+  if (options.udp) {
+    output->value("udp_gets", stats.udp_gets);
+    output->value("udp_lost", stats.udp_lost);
+    output->value("udp_reordered", stats.udp_reordered);
+    output->value("udp_late", stats.udp_late);
+  }
+  if (options.tls) {
+    output->value("tls_handshakes", stats.tls_handshakes);
+    output->value("tls_resumed", stats.tls_resumed);
+  }
+  if (options.churn > 0.0) output->value("reconnects", stats.reconnects);
+  if (options.trace) output->value("slow", stats.slow);
+  if (args.record_given) {
+    output->value("recorded", stats.recorded);
+    output->value("record_dropped", stats.record_dropped);
+  }
+  if (options.ramp > 0.0) output->value("connect_time", stats.connect_time);
+  if (stats.loaded) {
+    output->value("loaded", stats.loaded);
+    output->value("loaded_bytes", stats.loaded_bytes);
+    output->value("load_time", stats.load_stop - stats.load_start);
+  }
+  output->value("rx_bytes", stats.rx_bytes);
+  output->value("tx_bytes", stats.tx_bytes);
+  output->value("value_rx", stats.value_rx);
+  output->value("value_tx", stats.value_tx);
+  output->value("cpu_user", stats.cpu_user);
+  output->value("cpu_sys", stats.cpu_sys);
+  if (options.storm_at > 0.0)
+    output->value("storm_at", options.storm_at - stats.start);
+
+  // Microseconds, with buckets keyed by their upper bound.
+  output->section("latency");
+  output->sampler("read", stats.get_sampler, percentiles);
+  if (stats.sub_sampler.total())
+    output->sampler("sub", stats.sub_sampler, percentiles);
+  if (options.hedge)
+    output->sampler("nohedge", stats.nohedge_sampler, percentiles);
+  if (options.cache_aside)
+    output->sampler("miss", stats.miss_sampler, percentiles);
+  if (options.tls)
+    output->sampler("tls_hs", stats.handshake_sampler, percentiles);
+  if (options.churn > 0.0) {
+    output->sampler("stay", stats.stay_sampler, percentiles);
+    output->sampler("connect", stats.connect_sampler, percentiles);
+  }
+  output->sampler("update", stats.set_sampler, percentiles);
+  for (int i = Operation::SET + 1; i < Operation::COMMANDS; i++)
+    if (stats.cmd_ops[i])
+      output->sampler(Operation::name(i), stats.cmd_samplers[i], percentiles);
+  output->sampler("op_q", stats.op_sampler, percentiles);
+
+  if (options.slab_classes) {
+    stats.grow_classes(options.slab_classes - 1);
+    for (int c = 0; c < options.slab_classes; c++) {
+      string id = to_string(options.slab_id[c]);
+      output->sampler(("read_class" + id).c_str(),
+                      stats.class_get_samplers[c], percentiles);
+      output->sampler(("update_class" + id).c_str(),
+                      stats.class_set_samplers[c], percentiles);
+    }
+
+    // Chunk and value sizes, and the values moved, per class id.
+    output->section("classes");
+    for (int c = 0; c < options.slab_classes; c++) {
+      LogSampler &g = stats.class_get_samplers[c];
+      LogSampler &u = stats.class_set_samplers[c];
+      double bytes = (double) (stats.class_hits[c] + u.total()) *
+        options.slab_value[c];
+      output->row(to_string(options.slab_id[c]),
+                  {"chunk", "value", "qps", "mb_s"},
+                  {(double) options.slab_chunk[c],
+                   (double) options.slab_value[c],
+                   (g.total() + u.total()) / elapsed,
+                   bytes / 1024 / 1024 / elapsed});
+    }
+  }
+
+  if (args.server_given > 1) {
+    output->section("servers");
+    for (int s = 0; s < (int) args.server_given; s++) {
+      uint64_t ops = s < (int) stats.server_ops.size() ?
+        stats.server_ops[s] : 0;
+      uint64_t depth = s < (int) stats.server_ops.size() ?
+        stats.server_depth[s] : 0;
+      output->row(args.server_arg[s], {"requests", "share", "avg_queue"},
+                  {(double) ops, (double) ops / stats.sent() * 100,
+                   (double) depth / ops});
+    }
+  }
+
+  // Keyed by the end of the interval, in seconds into the measurement.
+  if (options.report > 0.0) {
+    output->section("intervals");
+    for (size_t i = 0; i < stats.intervals.size() &&
+           (i + 1) * options.report <= options.time + 1e-9; i++) {
+      interval_t &in = stats.intervals[i];
+      char at[32];
+      snprintf(at, sizeof(at), "%g", (i + 1) * options.report);
+      output->row(at, {"qps", "hit", "avg", "p99"},
+                  {in.ops / options.report, in.hit_percent(),
+                   in.get_average(), in.get_nth(99)});
+    }
+  }
+
+  output->end();
+}
+
+// The slowest requests of --trace-slow, then the connections and keys that
+// slow requests have in common.
+void print_traces(ConnectionStats& stats, uint64_t total) {
+  printf("Slow requests = %" PRIu64 " (%.2f%%)\n", stats.slow,
+         (double) stats.slow / total * 100);
+  if (stats.slow == 0) {
+    printf("\n");
+    return;
+  }
+
+  vector<trace_t> traces = stats.traces;
+  sort(traces.begin(), traces.end(), trace_t::slower);
+  int width = args.keysize_arg;
+
+  // Connections are server/connection; ahead are the requests answered
+  // just before one on its connection, with how much earlier they were
+  // sent.
+  printf("%-9s %9s %-7s %-*s %7s %9s %5s %6s\n", "#sent", "latency", "type",
+         width, "key", "size", "conn", "queue", "behind");
+  for (size_t i = 0; i < traces.size() && i < TRACE_PRINT; i++) {
+    trace_t &t = traces[i];
+    char conn[32];
+    snprintf(conn, 32, "%" PRIu64 "/%" PRIu64,
+             t.connection / MAXIMUM_CONNECTIONS,
+             t.connection % MAXIMUM_CONNECTIONS);
+    string key = t.key.substr(0, t.key.find(' '));
+    if (t.keys > 1) key += " +" + to_string(t.keys - 1);
+
+    printf("%-9.3f %9.1f %-7s %-*s %7d %9s %5d %6d\n",
+           t.start_time - stats.start, t.time(), Operation::name(t.type),
+           width, key.c_str(), t.size, conn, t.queue, t.behind);
+    for (auto &a: t.ahead)
+      printf("  ahead   %9.1f %-7s %-*" PRIu64 " sent %.1f us earlier\n",
+             (a.end_time - a.start_time) * 1000000, Operation::name(a.type),
+             width, a.key, (t.start_time - a.start_time) * 1000000);
+  }
+
+  vector<pair<uint64_t, uint64_t>> conns;
+  for (auto &c: stats.slow_connections)
+    conns.push_back(make_pair(c.second, c.first));
+  sort(conns.rbegin(), conns.rend());
+  printf("\nSlow requests by connection:");
+  for (size_t i = 0; i < conns.size() && i < 5; i++)
+    printf(" %" PRIu64 "/%" PRIu64 " %.1f%%",
+           conns[i].second / MAXIMUM_CONNECTIONS,
+           conns[i].second % MAXIMUM_CONNECTIONS,
+           (double) conns[i].first / stats.slow * 100);
+  printf("\n");
+
+  // Only the slowest are kept, so hot keys are counted among them.
+  map<string, int> keys;
+  for (auto &t: traces) keys[t.key]++;
+  vector<pair<int, string>> hot;
+  for (auto &k: keys)
+    if (k.second > 1) hot.push_back(make_pair(k.second, k.first));
+  sort(hot.rbegin(), hot.rend());
+  printf("Repeated keys among the %d slowest:", (int) traces.size());
+  for (size_t i = 0; i < hot.size() && i < 5; i++)
+    printf(" %s x%d", hot[i].second.c_str(), hot[i].first);
+  printf("%s\n\n", hot.empty() ? " none" : "");
+}
+
+// Each connection needs its descriptors, so raise the soft limit as far as
+// the hard limit allows.
+void raise_fd_limit(rlim_t needed) {
+  struct rlimit rl;
+
+  DIE_NZ(getrlimit(RLIMIT_NOFILE, &rl));
+  if (rl.rlim_cur >= needed) return;
+
+  rl.rlim_cur = rl.rlim_max == RLIM_INFINITY ? needed : min(needed, rl.rlim_max);
+  DIE_NZ(setrlimit(RLIMIT_NOFILE, &rl));
+
+  if (rl.rlim_cur < needed) {
+    char buf[100];
+    snprintf(buf, 100, "Need %lu file descriptors, hard limit is %lu",
+             (unsigned long) needed, (unsigned long) rl.rlim_max);
+    die(buf);
   }
 }
 
-void run(const vector<pair<string, int>>& servers, options_t& options, ConnectionStats& stats) {
+void run(const vector<pair<string, int>>& servers, options_t& options,
+         ConnectionStats& stats, KeyRouter* router, int id) {
   struct event_base *base;
   struct evdns_base *evdns;
 
-  DIE_Z(base = event_base_new());
+  // The default coarse monotonic clock would delay backend fetches and
+  // hedges by up to a scheduler tick.
+  struct event_config *config;
+  DIE_Z(config = event_config_new());
+  DIE_NZ(event_config_set_flag(config, EVENT_BASE_FLAG_PRECISE_TIMER));
+  DIE_Z(base = event_base_new_with_config(config));
+  event_config_free(config);
   DIE_Z(evdns = evdns_base_new(base, 1));
   
   double start = get_time();
   double now = start;
+  double load_start = 0.0, load_stop = 0.0;
 
   vector<Connection*> connections;
-  vector<Connection*> server_lead;
+  vector<uint64_t> streams;
+  vector<vector<Connection*>> pools(servers.size());
 
-  for (auto s: servers) {
-    for (int c = 0; c < options.connections; c++) {
-      Connection *conn = new Connection(base, evdns, s.first, s.second, options);
+  // Thread id owns connections id, id + threads, ... to every server.
+  for (size_t s = 0; s < servers.size(); s++) {
+    for (int c = id; c < options.connections; c += options.threads) {
+      // Connection c to server s draws stream c of the seed for server s,
+      // whatever the number of threads.
+      uint64_t stream = s * MAXIMUM_CONNECTIONS + c;
+      Connection *conn = createConnection(base, evdns, servers[s].first,
+                                          servers[s].second, options, stats,
+                                          stream);
       connections.push_back(conn);
-      if (c == 0) server_lead.push_back(conn);
+      streams.push_back(stream);
+      pools[s].push_back(conn);
     }   
   }
 
+  // The n-th connection of every server pool forms the set of peers that
+  // the n-th connection to each server sends keys and fan-outs to.
+  for (size_t s = 0; s < servers.size(); s++) {
+    for (size_t c = 0; c < pools[s].size(); c++) {
+      vector<Connection*> peers;
+      for (auto &pool: pools) peers.push_back(pool[c]);
+      pools[s][c]->set_routing(router, peers, s);
+    }
+  }
+
+  // Backup copies of hedged gets go to the next connection to the same
+  // server, or to the next server when every server holds every key.
+  if (options.hedge) {
+    for (size_t s = 0; s < servers.size(); s++) {
+      for (size_t c = 0; c < pools[s].size(); c++) {
+        vector<Connection*> backups;
+        for (size_t b = 0; b < servers.size(); b++) {
+          if (pools[b].size() > 1)
+            backups.push_back(pools[b][(c + 1) % pools[b].size()]);
+          else if (!router && servers.size() > 1)
+            backups.push_back(pools[(b + 1) % servers.size()][c]);
+          else
+            die("--hedge needs two connections per server in every thread, "
+                "or several servers with --hash=none");
+        }
+        pools[s][c]->set_backups(backups);
+      }
+    }
+  }
+
+  double connect_start = get_time();
+  open_connections(base, connections, options.ramp / options.threads);
   wait_until_idle(base, connections);
-  for (auto c: server_lead) c->start_loading();
-  wait_until_idle(base, connections);
+  double connected = get_time();
+
+  // Every connection loads its own slice of its server's records.
+  if (!options.noload) {
+    pthread_barrier_wait(&barrier);
+    load_start = get_time();
+
+    size_t i = 0;
+    for (size_t s = 0; s < servers.size(); s++) {
+      for (int c = id; c < options.connections; c += options.threads) {
+        int from = (int64_t) options.records * c / options.connections;
+        int to = (int64_t) options.records * (c + 1) / options.connections;
+        connections[i++]->start_loading(from, to);
+      }
+    }
+
+    wait_until_idle(base, connections);
+  }
+
+  // All threads start measuring together, once every load has finished.
+  pthread_barrier_wait(&barrier);
+  if (!options.noload) load_stop = get_time();
+
+  struct rusage usage_start, usage_stop;
+  DIE_NZ(getrusage(RUSAGE_THREAD, &usage_start));
 
   start = get_time();
+  stats.start = start;
+  stats.report = options.report;
   for (Connection *conn: connections) {
     conn->start_time = start;
+    conn->record = record_ring(id);
     conn->start();
   }
 
+  // The thread's stats are published for --metrics every METRICS_PUBLISH.
+  MetricsSlot *metrics = metrics_slot(id);
+  double next_publish = start;
+
+  vector<churn_data> churns;
+  if (options.churn > 0.0) {
+    churns.resize(connections.size());
+    for (size_t i = 0; i < connections.size(); i++) {
+      churn_data &churn = churns[i];
+      churn = {connections[i], Random(options.seed, ~streams[i]),
+               options.churn, NULL};
+      DIE_Z(churn.timer = evtimer_new(base, churn_cb, &churn));
+      churn_schedule(&churn);
+    }
+  }
+
   while (1) {
     event_base_loop(base, EVLOOP_NONBLOCK);
     struct timeval now_tv;
     event_base_gettimeofday_cached(base, &now_tv);
     now = tv_to_double(&now_tv);
 
+    if (metrics && now >= next_publish) {
+      metrics->publish(stats, now);
+      next_publish = now + METRICS_PUBLISH;
+    }
+
+    // Scanning every connection is costly with many of them, so only start
+    // once the run time is over.
+    if (now <= start + options.time) continue;
+
     bool restart = false;
     for (Connection *conn: connections)
       if (!conn->check_exit_condition(now))
@@ -142,18 +732,35 @@ void run(const vector<pair<string, int>>& servers, options_t& options, Connectio
     else break;
   }
 
-  for (Connection *conn: connections) {
-    stats.accumulate(conn->stats);
-    delete conn;
-  }
+  DIE_NZ(getrusage(RUSAGE_THREAD, &usage_stop));
+  stats.cpu_user = tv_to_double(&usage_stop.ru_utime) -
+    tv_to_double(&usage_start.ru_utime);
+  stats.cpu_sys = tv_to_double(&usage_stop.ru_stime) -
+    tv_to_double(&usage_start.ru_stime);
+
+  for (auto &churn: churns) event_free(churn.timer);
+  for (Connection *conn: connections) delete conn;
 
+  stats.connect_time = connected - connect_start;
   stats.start = start;
   stats.stop = now;
+  stats.load_start = load_start;
+  stats.load_stop = load_stop;
 
   evdns_base_free(evdns, 0);
   event_base_free(base);
 }
 
+void* thread_main(void *arg) {
+  struct thread_data *td = (struct thread_data *) arg;
+
+  ConnectionStats *cs = new ConnectionStats();
+
+  run(*td->servers, *td->options, *cs, td->router, td->id);
+
+  return cs;
+}
+
 int main(int argc, char **argv) {
   DIE_NZ(cmdline_parser(argc, argv, &args));
 
@@ -174,6 +781,80 @@ int main(int argc, char **argv) {
   }
   if (args.server_given == 0)
     die("--server must be specified.");
+  if (args.threads_arg < 1 || args.threads_arg > args.connections_arg)
+    die("--threads must be between [1,--connections]");
+  if (args.multiget_arg < 1)
+    die("--multiget must be >= 1");
+  if (args.fanout_arg < 1 || args.fanout_arg > (int) args.server_given)
+    die("--fanout must be between [1,number of servers]");
+  for (unsigned int s = 0; s < args.server_given; s++)
+    if (args.udp_flag && !strncmp(args.server_arg[s], "unix:", 5))
+      die("--udp cannot be used with UNIX socket servers");
+  if (args.mix_given && strcmp(args.balance_arg, "none"))
+    die("--mix cannot be used with --balance");
+  if (args.keyspace_given && args.keyspace_arg < args.records_arg)
+    die("--keyspace must be >= --records");
+  if (args.hit_ratio_given && (args.hit_ratio_arg < 0.0 || args.hit_ratio_arg > 1.0))
+    die("--hit-ratio must be between [0,1]");
+  if (args.zipf_arg < 0.0)
+    die("--zipf must be >= 0");
+  if (args.zipf_arg > 0.0 && args.hit_ratio_given)
+    die("--zipf cannot be used with --hit-ratio");
+  if ((args.hot_drift_given || args.hot_jump_given) && args.zipf_arg <= 0.0)
+    die("--hot-drift and --hot-jump need --zipf");
+  if (args.hot_drift_arg < 0.0 || args.hot_jump_arg < 0.0)
+    die("--hot-drift and --hot-jump must be >= 0");
+  if (args.expire_storm_arg < 0.0)
+    die("--expire-storm must be >= 0");
+  if (args.expire_storm_given && args.noload_flag)
+    die("--expire-storm needs the loading phase");
+  if (args.expire_fraction_arg < 0.0 || args.expire_fraction_arg > 1.0)
+    die("--expire-fraction must be between [0,1]");
+  if (args.report_arg < 0.0)
+    die("--report must be >= 0");
+  if (args.noreply_arg < 0)
+    die("--noreply must be >= 0");
+  if (args.slab_classes_arg < 0 || args.slab_classes_arg > MAX_SLAB_CLASSES) {
+    snprintf(buf, 100, "--slab-classes must be between [0,%d]", MAX_SLAB_CLASSES);
+    die(buf);
+  }
+  if (args.slab_factor_arg <= 1.0)
+    die("--slab-factor must be > 1");
+  if (args.slab_chunk_arg < 1)
+    die("--slab-chunk must be >= 1");
+  if (args.verify_flag && args.valuesize_arg < (int) sizeof(verify_header_t)) {
+    snprintf(buf, 100, "--verify needs --valuesize >= %d",
+             (int) sizeof(verify_header_t));
+    die(buf);
+  }
+  if (args.verify_flag && args.udp_flag)
+    die("--verify cannot be used with --udp");
+  if (args.verify_flag && args.mix_given &&
+      (strstr(args.mix_arg, "append") || strstr(args.mix_arg, "prepend")))
+    die("--verify cannot be used with append or prepend");
+  if (args.tls_flag && args.udp_flag)
+    die("--tls cannot be used with --udp");
+  if (args.tls_resume_flag && !args.tls_flag)
+    die("--tls-resume needs --tls");
+  if (strcmp(args.balance_arg, "none") && strcmp(args.hash_arg, "none"))
+    die("--balance needs --hash=none");
+  if (args.hedge_given && (args.hedge_arg[0] == 'p' ?
+                           atof(args.hedge_arg + 1) <= 0.0 ||
+                           atof(args.hedge_arg + 1) >= 100.0 :
+                           atof(args.hedge_arg) < 0.0))
+    die("--hedge must be a time >= 0 or a percentile p0 < pNN < p100");
+  if (args.trace_slow_given && (args.trace_slow_arg[0] == 'p' ?
+                                atof(args.trace_slow_arg + 1) <= 0.0 ||
+                                atof(args.trace_slow_arg + 1) >= 100.0 :
+                                atof(args.trace_slow_arg) < 0.0))
+    die("--trace-slow must be a time >= 0 or a percentile p0 < pNN < p100");
+
+  Output *output = createOutput(args.output_arg, stdout);
+  vector<double> percentiles = parse_percentiles(args.percentiles_arg);
+
+  // With --udp every connection also has a datagram socket.
+  raise_fd_limit((rlim_t) args.connections_arg * args.server_given *
+                 (args.udp_flag ? 2 : 1) + RESERVED_FDS);
 
   setvbuf(stdout, NULL, _IONBF, 0);
   init_random_char();
@@ -185,16 +866,84 @@ int main(int argc, char **argv) {
   for (unsigned int s = 0; s < args.server_given; s++)
     servers.push_back(string_to_addr(string(args.server_arg[s])));
 
+  KeyRouter *router = createKeyRouter(args.hash_arg, servers);
+  if (options.tls) tls_init(args.tls_resume_flag);
+  if (args.metrics_given) metrics_start(args.metrics_arg, options.threads);
+  if (args.record_given) record_start(args.record_arg, options.threads);
+  if (options.verify)
+    verify_init(router || options.balance ? 1 : servers.size(),
+                options.keyspace);
+
   ConnectionStats stats;
 
-  run(servers, options, stats);
+  vector<pthread_t> pt(options.threads);
+  vector<struct thread_data> td(options.threads);
+
+  DIE_NZ(pthread_barrier_init(&barrier, NULL, options.threads));
+
+  for (int t = 0; t < options.threads; t++) {
+    td[t].servers = &servers;
+    td[t].options = &options;
+    td[t].router = router;
+    td[t].id = t;
+    DIE_NZ(pthread_create(&pt[t], NULL, thread_main, &td[t]));
+  }
+
+  for (int t = 0; t < options.threads; t++) {
+    ConnectionStats *cs;
+    DIE_NZ(pthread_join(pt[t], (void **) &cs));
+    stats.accumulate(*cs);
+    delete cs;
+  }
+
+  pthread_barrier_destroy(&barrier);
+  metrics_stop();
+  record_stop();
+  delete router;
+  if (options.tls) tls_cleanup();
+
+  if (output) {
+    print_output(output, stats, options, percentiles);
+    delete output;
+    cmdline_parser_free(&args);
+    return 0;
+  }
+
+  if (options.ramp > 0.0) {
+    int opened = options.connections * servers.size();
+    printf("Opened %d connections in %.1fs (%.1f connections/s)\n\n",
+           opened, stats.connect_time, opened / stats.connect_time);
+  }
+
+  if (stats.loaded) {
+    double load_time = stats.load_stop - stats.load_start;
+    printf("Loaded %" PRIu64 " records in %.1fs (%.1f records/s, %.1f MB/s)\n\n",
+           stats.loaded, load_time, stats.loaded / load_time,
+           (double) stats.loaded_bytes / 1024 / 1024 / load_time);
+  }
 
   stats.print_header();
   stats.print_stats("read",   stats.get_sampler);
+  if (stats.sub_sampler.total())
+    stats.print_stats("sub",  stats.sub_sampler);
+  if (options.hedge)
+    stats.print_stats("nohedge", stats.nohedge_sampler);
+  if (options.cache_aside)
+    stats.print_stats("miss",   stats.miss_sampler);
+  if (options.tls)
+    stats.print_stats("tls_hs",  stats.handshake_sampler);
+  if (options.churn > 0.0) {
+    stats.print_stats("stay",    stats.stay_sampler);
+    stats.print_stats("connect", stats.connect_sampler);
+  }
   stats.print_stats("update", stats.set_sampler);
+  for (int i = Operation::SET + 1; i < Operation::COMMANDS; i++)
+    if (stats.cmd_ops[i])
+      stats.print_stats(Operation::name(i), stats.cmd_samplers[i]);
   stats.print_stats("op_q",   stats.op_sampler);
 
   int total = stats.gets + stats.sets;
+  for (int i = 0; i < Operation::COMMANDS; i++) total += stats.cmd_ops[i];
 
   printf("\nTotal QPS = %.1f (%d / %.1fs)\n",
           total / (stats.stop - stats.start),
@@ -203,17 +952,156 @@ int main(int argc, char **argv) {
   printf("\n");
 
   printf("Misses = %" PRIu64 " (%.1f%%)\n", stats.get_misses,
-          (double) stats.get_misses/stats.gets*100);
+          (double) stats.get_misses/stats.get_keys*100);
 
   printf("Skipped TXs = %" PRIu64 " (%.1f%%)\n\n", stats.skips,
           (double) stats.skips / total * 100);
 
+  if (options.cache_aside) {
+    printf("Refills = %" PRIu64 " (%.1f/s)\n\n", stats.refills,
+           stats.refills / (stats.stop - stats.start));
+  }
+
+  if (options.mix) {
+    for (int i = Operation::SET + 1; i < Operation::COMMANDS; i++) {
+      if (stats.cmd_ops[i] == 0) continue;
+      printf("%-7s = %" PRIu64 " (%.1f%% not found)\n", Operation::name(i),
+             stats.cmd_ops[i],
+             (double) stats.cmd_misses[i] / stats.cmd_ops[i] * 100);
+    }
+    if (stats.cmd_ops[Operation::CAS])
+      printf("CAS retries = %" PRIu64 " (%.2f per cas)\n", stats.cas_retries,
+             (double) stats.cas_retries / stats.cmd_ops[Operation::CAS]);
+    printf("\n");
+  }
+
+  if (options.hedge) {
+    printf("Hedged gets = %" PRIu64 " (%.1f%% extra gets), "
+           "backup won %" PRIu64 " (%.1f%%)\n\n",
+           stats.hedges, (double) stats.hedges / stats.gets * 100,
+           stats.hedge_wins, (double) stats.hedge_wins / stats.hedges * 100);
+  }
+
+  if (options.noreply) {
+    printf("Fences = %" PRIu64 " (%.1f sets per fence)\n\n", stats.fences,
+           (double) stats.sets / stats.fences);
+  }
+
+  if (options.verify) {
+    printf("Verified values = %" PRIu64 ", corrupt %" PRIu64 ", "
+           "stale %" PRIu64 "\n\n", stats.verified, stats.corrupt, stats.stale);
+  }
+
+  if (args.record_given) {
+    printf("Recorded %" PRIu64 " requests to %s, dropped %" PRIu64 "\n\n",
+           stats.recorded, args.record_arg, stats.record_dropped);
+  }
+
+  if (options.udp) {
+    printf("UDP gets = %" PRIu64 ", lost %" PRIu64 " (%.2f%%), "
+           "reordered answers %" PRIu64 ", late datagrams %" PRIu64 "\n\n",
+           stats.udp_gets, stats.udp_lost,
+           (double) stats.udp_lost / stats.udp_gets * 100,
+           stats.udp_reordered, stats.udp_late);
+  }
+
+  if (options.tls) {
+    printf("TLS handshakes = %" PRIu64 ", resumed %" PRIu64 " (%.1f%%)\n\n",
+           stats.tls_handshakes, stats.tls_resumed,
+           (double) stats.tls_resumed / stats.tls_handshakes * 100);
+  }
+
+  if (options.churn > 0.0) {
+    double elapsed = stats.stop - stats.start;
+    printf("Reconnects = %" PRIu64 " (%.1f/s)\n\n", stats.reconnects,
+           stats.reconnects / elapsed);
+  }
+
+  if (servers.size() > 1) {
+    uint64_t max_ops = 0;
+
+    printf("Server load:\n");
+    for (size_t s = 0; s < servers.size(); s++) {
+      uint64_t ops = s < stats.server_ops.size() ? stats.server_ops[s] : 0;
+      uint64_t depth = s < stats.server_ops.size() ? stats.server_depth[s] : 0;
+      if (ops > max_ops) max_ops = ops;
+      printf("  %-21s %10" PRIu64 " requests (%5.1f%%), avg queue %.1f\n",
+             args.server_arg[s], ops,
+             (double) ops / stats.sent() * 100, (double) depth / ops);
+    }
+    printf("  max/mean = %.2f\n\n",
+           (double) max_ops * servers.size() / stats.sent());
+  }
+
+  if (options.slab_classes) {
+    double elapsed = stats.stop - stats.start;
+    stats.grow_classes(options.slab_classes - 1);
+
+    printf("%-7s %7s %7s %9s %7s %9s %9s %9s %9s\n", "#class", "chunk",
+           "value", "QPS", "MB/s", "get avg", "get 99th", "set avg",
+           "set 99th");
+    for (int c = 0; c < options.slab_classes; c++) {
+      LogSampler &g = stats.class_get_samplers[c];
+      LogSampler &u = stats.class_set_samplers[c];
+      // Values moved: the gets that hit and every set.
+      double bytes = (double) (stats.class_hits[c] + u.total()) *
+        options.slab_value[c];
+
+      printf("%-7d %7d %7d %9.1f %7.1f %9.1f %9.1f %9.1f %9.1f\n",
+             options.slab_id[c],
+             options.slab_chunk[c], options.slab_value[c],
+             (g.total() + u.total()) / elapsed, bytes / 1024 / 1024 / elapsed,
+             g.total() ? g.average() : 0.0, g.total() ? g.get_nth(99) : 0.0,
+             u.total() ? u.average() : 0.0, u.total() ? u.get_nth(99) : 0.0);
+    }
+    printf("\n");
+  }
+
+  if (options.storm_at > 0.0)
+    printf("Expiry storm at %.1fs into the measurement\n\n",
+           options.storm_at - stats.start);
+
+  if (options.report > 0.0) {
+    printf("%-7s %9s %7s %9s %9s\n", "#time", "QPS", "hit%", "avg", "99th");
+    // Requests still answered after --time fall outside the last interval.
+    for (size_t i = 0; i < stats.intervals.size() &&
+           (i + 1) * options.report <= options.time + 1e-9; i++) {
+      interval_t &in = stats.intervals[i];
+      double from = stats.start + i * options.report;
+      bool storm = options.storm_at >= from &&
+        options.storm_at < from + options.report;
+      printf("%-7.1f %9.1f %7.1f %9.1f %9.1f%s\n", (i + 1) * options.report,
+             in.ops / options.report, in.hit_percent(),
+             in.get_average(), in.get_nth(99),
+             storm ? "  <- expiry storm" : "");
+    }
+    printf("\n");
+  }
+
+  if (options.trace) print_traces(stats, total);
+
+  // Large values are bandwidth-bound, so also show what moving them cost.
+  if (stats.value_rx + stats.value_tx >=
+      (stats.gets + stats.sets) * VALUE_REFERENCE) {
+    double elapsed = stats.stop - stats.start;
+    printf("Values read %.1f MB/s (%.1f us per KB), "
+           "written %.1f MB/s (%.1f us per KB)\n\n",
+           (double) stats.value_rx / 1024 / 1024 / elapsed,
+           stats.get_sampler.sum / (stats.value_rx / 1024.0),
+           (double) stats.value_tx / 1024 / 1024 / elapsed,
+           stats.set_sampler.sum / (stats.value_tx / 1024.0));
+  }
+
   printf("RX %10" PRIu64 " bytes : %6.1f MB/s\n",
           stats.rx_bytes,
           (double) stats.rx_bytes / 1024 / 1024 / (stats.stop - stats.start));
   printf("TX %10" PRIu64 " bytes : %6.1f MB/s\n",
           stats.tx_bytes,
           (double) stats.tx_bytes / 1024 / 1024 / (stats.stop - stats.start));
+  printf("Seed = %" PRIu64 "\n", options.seed);
+  printf("CPU = %.2fs user, %.2fs sys (%.1f us per request)\n",
+         stats.cpu_user, stats.cpu_sys,
+         (stats.cpu_user + stats.cpu_sys) / total * 1000000);
 
   cmdline_parser_free(&args);
 }
\ No newline at end of file
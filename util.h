@@ -9,12 +9,20 @@
 #define DIE_Z(x)  do { if (!(x)) die("error: " #x " failed (returned zero/null)."); } while (0)
 #define DIE_NE(x) do { if ((x) < 0) die("error: " #x " failed (returned negative)." ); } while (0)
 
-void die(const char *reason);
+void die(const char *reason) __attribute__((noreturn));
 
 inline double tv_to_double(struct timeval *tv) {
   return tv->tv_sec + (double) tv->tv_usec / 1000000;
 }
 
+inline void double_to_tv(double val, struct timeval *tv) {
+  long long secs = (long long) val;
+  long long usecs = (long long) ((val - secs) * 1000000);
+
+  tv->tv_sec = secs;
+  tv->tv_usec = usecs;
+}
+
 inline double get_time() {
   struct timeval tv;
   gettimeofday(&tv, NULL);